@@ -17,13 +17,15 @@ namespace sandbox
 
   /**
    * The body of the callback request message.  This is sent over a UNIX domain
-   * socket.  The privileged code has access to the sandbox's memory; however,
-   * and so most of the message payload is in sandbox-owned memory within the
-   * sandbox.  The payload sent over the socket is small enough that the kernel
-   * can trivially buffer it and do two-copy I/O without any noticeable
-   * overhead.  The host can then do one-copy I/O from the shared region to
-   * avoid TOCTOU bugs, without needing to lock pages or any of the other
-   * operations that make this expensive in an in-kernel implementation.
+   * socket if the callback passes a file descriptor, and otherwise through the
+   * mailbox in the shared memory region (see `CallbackMailbox`).  The
+   * privileged code has access to the sandbox's memory; however, and so most
+   * of the message payload is in sandbox-owned memory within the sandbox.
+   * The payload sent over the socket is small enough that the kernel can
+   * trivially buffer it and do two-copy I/O without any noticeable overhead.
+   * The host can then do one-copy I/O from the shared region to avoid TOCTOU
+   * bugs, without needing to lock pages or any of the other operations that
+   * make this expensive in an in-kernel implementation.
    */
   struct CallbackRequest
   {
@@ -75,7 +77,8 @@ namespace sandbox
     struct Result
     {
       /**
-       * The return integer value.  This is passed directly via the socket.
+       * The return integer value.  This is passed directly via the socket or
+       * the mailbox.
        */
       intptr_t integer = -ENOSYS;
 
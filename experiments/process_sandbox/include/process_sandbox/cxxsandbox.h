@@ -117,6 +117,50 @@ namespace sandbox
         lib.free(callframe);
       }
     }
+
+    /**
+     * Asynchronous call.  Queues the call in the sandbox's request ring and
+     * returns a future for the return value, so that calls from several
+     * threads can be run by the child in one batch.
+     *
+     * The argument frame is freed when the call completes, whether or not the
+     * future is ever waited for.
+     */
+    std::future<Ret> async(Args... args)
+    {
+      auto cf = lib.alloc<CallFrame>();
+      if (!cf)
+      {
+        throw std::bad_alloc();
+      }
+      CallFrame* callframe = cf.value();
+      callframe->args = std::forward_as_tuple(args...);
+      // `std::function` must be copyable, so the promise is shared.
+      auto promise = std::make_shared<std::promise<Ret>>();
+      auto result = promise->get_future();
+      lib.send_async(
+        vtable_index,
+        callframe,
+        [&lib = lib, callframe, promise](std::exception_ptr e) {
+          if (e)
+          {
+            lib.free(callframe);
+            promise->set_exception(e);
+          }
+          else if constexpr (!std::is_void_v<Ret>)
+          {
+            Ret r = callframe->ret;
+            lib.free(callframe);
+            promise->set_value(std::move(r));
+          }
+          else
+          {
+            lib.free(callframe);
+            promise->set_value();
+          }
+        });
+      return result;
+    }
   };
 
   /**
@@ -23,12 +23,26 @@
  * Blocks for either the specified number of milliseconds have elapsed or
  * until `wake` is called.  Returns true if the return is in response to a wake
  * event, false if it is in response to a timeout.
+ *
+ * ```
+ * bool try_wait();
+ * ```
+ *
+ * Acquires the semaphore if `wake` has been called, without blocking.
+ * Returns true if the semaphore was acquired.
+ *
+ * There is at most one waiter at a time.  `wake` should avoid a system call
+ * if the waiter is not blocked in the kernel, so that a waiter that spins
+ * with `try_wait` (see `AdaptiveSpin`) can be woken cheaply.
  */
 
 #include "onebitsem_futex.h"
 #include "onebitsem_umtx.h"
 //#include "onebitsem_posix.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace sandbox
 {
   namespace platform
@@ -44,5 +58,106 @@ namespace sandbox
 #  error No one-bit semaphore defined for your platform
 #endif
       ;
+
+    /**
+     * Waits on a `OneBitSem`, spinning for a while before sleeping.
+     *
+     * Handing the token between the parent and the child costs a system call
+     * to wake the other side and another to sleep, and then a context switch
+     * on each side.  For short calls this dominates, and it is cheaper for the
+     * waiter to spin until the other side wakes it.  Spinning for long calls
+     * wastes a core, so each waiter keeps a moving average of how long its
+     * recent waits took, and spins only while that is short.
+     *
+     * Each side keeps its own instances, in memory that the other side cannot
+     * write, so the child cannot make the parent spin for longer.
+     */
+    class AdaptiveSpin
+    {
+      using Clock = std::chrono::steady_clock;
+
+      /**
+       * Waits longer than this on average are not worth spinning for.
+       */
+      static constexpr std::chrono::nanoseconds max_spin =
+        std::chrono::microseconds(50);
+
+      /**
+       * The shortest time to spin for, if spinning at all.
+       */
+      static constexpr std::chrono::nanoseconds min_spin =
+        std::chrono::microseconds(1);
+
+      /**
+       * The moving average of the durations of recent waits, in nanoseconds.
+       * Each new wait contributes 1/8 of the average.
+       */
+      int64_t average_ns = 0;
+
+      /**
+       * Whether to spin at all.  Spinning only helps if the other side can run
+       * at the same time, on another core.
+       */
+      bool enabled;
+
+    public:
+      /**
+       * Constructor.  If `enabled` is false then waits never spin.
+       */
+      AdaptiveSpin(bool enabled) : enabled(enabled) {}
+
+      /**
+       * Returns whether waits may spin.
+       */
+      bool is_enabled() const
+      {
+        return enabled;
+      }
+
+      /**
+       * The time to spin before sleeping: twice the recent average, within
+       * `min_spin` and `max_spin`, if that is short enough to be worth
+       * spinning for.
+       */
+      std::chrono::nanoseconds spin_time() const
+      {
+        std::chrono::nanoseconds average(average_ns);
+        if (!enabled || (average > max_spin))
+        {
+          return std::chrono::nanoseconds(0);
+        }
+        return std::clamp<std::chrono::nanoseconds>(
+          2 * average, min_spin, max_spin);
+      }
+
+      /**
+       * Wait on `sem`, spinning for `spin_time` and then sleeping for at most
+       * `milliseconds`.  Returns true if the semaphore was acquired, as
+       * `OneBitSem::wait`.
+       */
+      bool wait(OneBitSem& sem, int milliseconds)
+      {
+        auto start = Clock::now();
+        auto spin_until = start + spin_time();
+        bool acquired = sem.try_wait();
+        while (!acquired && (Clock::now() < spin_until))
+        {
+          snmalloc::Aal::pause();
+          acquired = sem.try_wait();
+        }
+        if (!acquired)
+        {
+          acquired = sem.wait(milliseconds);
+        }
+        // Timeouts do not say how long the call took, so are not recorded.
+        if (acquired)
+        {
+          auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - start);
+          average_ns += (duration.count() - average_ns) / 8;
+        }
+        return acquired;
+      }
+    };
   }
 }
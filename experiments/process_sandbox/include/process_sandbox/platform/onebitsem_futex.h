@@ -23,6 +23,12 @@ namespace sandbox::platform
      * Attempting to wait while the value is 0 will block.
      */
     std::atomic<int> flag = {0};
+    /**
+     * Set while a waiter may be sleeping in the kernel.  A wake makes a
+     * system call only if this is set, so waking a waiter that is spinning,
+     * or that has not yet started to wait, does not.
+     */
+    std::atomic<bool> has_waiter = {false};
     int
     futex_op(int futex_op, int val, const struct timespec* timeout = nullptr)
     {
@@ -38,27 +44,40 @@ namespace sandbox::platform
     }
     void wake()
     {
-      uint32_t old = flag.fetch_add(1, std::memory_order_release);
+      // This and the accesses in `wait` are sequentially consistent so that
+      // either the waiter sees the new value of the flag before sleeping, or
+      // this sees that the waiter may be sleeping.
+      uint32_t old = flag.fetch_add(1);
       SANDBOX_INVARIANT(
         old == 0,
         "Waking up one-bit semaphore that's already awake.  Count: {}.",
         old);
-      futex_op(FUTEX_WAKE, 1);
+      if (has_waiter)
+      {
+        futex_op(FUTEX_WAKE, 1);
+      }
+    }
+    bool try_wait()
+    {
+      int f = flag.load();
+      if (f > 0)
+      {
+        assert(f == 1);
+        return flag.compare_exchange_strong(
+          f, f - 1, std::memory_order_acquire, std::memory_order_acquire);
+      }
+      return false;
     }
     bool wait(int milliseconds)
     {
-      auto try_lock = [&]() {
-        int f = flag.load();
-        if (f > 0)
-        {
-          assert(f == 1);
-          return flag.compare_exchange_strong(
-            f, f - 1, std::memory_order_acquire, std::memory_order_acquire);
-        }
-        return false;
-      };
-      if (try_lock())
+      if (try_wait())
+      {
+        return true;
+      }
+      has_waiter = true;
+      if (try_wait())
       {
+        has_waiter = false;
         return true;
       }
       // Note: we always retry with the same timeout because futex doesn't give
@@ -72,7 +91,8 @@ namespace sandbox::platform
         ret = futex_op(FUTEX_WAIT, 0, &timeout);
       } while ((ret == -1) && (errno == EINTR));
       assert((ret != -1) || ((errno == ETIMEDOUT) || (errno == EAGAIN)));
-      return try_lock();
+      has_waiter = false;
+      return try_wait();
     }
   };
 }
@@ -9,6 +9,7 @@ SANDBOX_CLANG_DIAGNOSTIC_IGNORE("-Wmissing-field-initializers")
 #  include <seccomp.h>
 SANDBOX_CLANG_DIAGNOSTIC_POP()
 #  include <assert.h>
+#  include <errno.h>
 #  include <process_sandbox/sandbox_fd_numbers.h>
 
 namespace sandbox
@@ -400,8 +401,9 @@ namespace sandbox
         deny(SCMP_SYS(request_key));
         deny(SCMP_SYS(keyctl));
         // Can't check args, could potentially catch a trap and call `clone`
-        // with safe args.
-        deny(SCMP_SYS(clone3));
+        // with safe args.  Fail rather than killing the process, so that libc
+        // falls back to `clone` when creating threads.
+        add_rule(SCMP_ACT_ERRNO(ENOSYS), SCMP_SYS(clone3));
 
         // These system calls can be handled sometimes, depending on the
         // dynamic policy.
@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <array>
+#include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <string.h>
@@ -28,6 +31,8 @@ namespace sandbox
   class ExportedFileTree;
   struct CallbackHandlerBase;
   class Library;
+  template<typename T>
+  class SandboxPool;
 
   /**
    * An snmalloc Platform Abstraction Layer (PAL) that cannot be used to
@@ -517,6 +522,12 @@ namespace sandbox
      */
     std::unique_ptr<SharedAlloc> allocator;
 
+    /**
+     * Lock protecting `allocator`, which is not thread safe, from threads
+     * allocating or freeing sandbox memory around concurrent calls.
+     */
+    std::mutex alloc_lock;
+
     /**
      * The handle to the socket that is used to pass file descriptors to the
      * sandboxed process.
@@ -629,8 +640,16 @@ namespace sandbox
     /**
      * Constructor.  Creates a new sandboxed instance of the library named by
      * `library_name`, with the heap size specified in GiBs.
+     *
+     * The child runs synchronous calls on a single thread.  If
+     * `worker_threads` is not zero then it also starts that many threads
+     * (up to `SharedMemoryRegion::max_worker_threads`), which run batches of
+     * asynchronous calls in parallel.
      */
-    Library(const char* library_name, size_t heap_size_in_GiBs = 1);
+    Library(
+      const char* library_name,
+      size_t heap_size_in_GiBs = 1,
+      uint32_t worker_threads = 0);
     /**
      * Allocate space for an array of `count` instances of `T`.  Objects in the
      * array will be default constructed.
@@ -790,6 +809,80 @@ namespace sandbox
      * need to wait for it to be ready before we invoke it.
      */
     bool is_first_call = true;
+
+    /**
+     * Lock held by the thread that passes the token to the child, for a
+     * synchronous call or to run queued asynchronous calls.  This is recursive
+     * because a callback handler, which runs with the lock held, may call back
+     * into the sandbox.
+     */
+    std::recursive_mutex call_lock;
+
+    /**
+     * Chooses how long the thread that holds `call_lock` spins, waiting for
+     * the child to return the token, before it sleeps.
+     */
+    platform::AdaptiveSpin call_spin;
+
+    /**
+     * Lock protecting the parent's view of the call rings: `request_tail`,
+     * `completion_head`, `dispatched_tail`, `in_flight`, and `child_failed`.
+     */
+    std::mutex ring_lock;
+
+    /**
+     * The parent's copy of the tail of the request ring, see `SharedRing`.
+     * This is also the identifier of the next asynchronous call.
+     */
+    uint32_t request_tail = 0;
+
+    /**
+     * The parent's copy of the head of the completion ring.
+     */
+    uint32_t completion_head = 0;
+
+    /**
+     * The value of `request_tail` when the token was last passed to the
+     * child.  Calls after this have been queued but the child may not have
+     * seen them.
+     */
+    uint32_t dispatched_tail = 0;
+
+    /**
+     * An asynchronous call that has been queued but not completed.
+     */
+    struct InFlightCall
+    {
+      /**
+       * The identifier of the call.
+       */
+      uint32_t id;
+
+      /**
+       * Is this slot in use?
+       */
+      bool active = false;
+
+      /**
+       * Called when the call completes, with a null exception, or with the
+       * exception that it failed with.
+       */
+      std::function<void(std::exception_ptr)> done;
+    };
+
+    /**
+     * Asynchronous calls in flight, indexed by identifier modulo the ring
+     * size.  This is in parent-owned memory and so the child cannot forge a
+     * completion for a call that was not made.
+     */
+    std::array<InFlightCall, SharedMemoryRegion::call_ring_size> in_flight;
+
+    /**
+     * Set if the child exited while running asynchronous calls.  Any later
+     * asynchronous calls fail immediately.
+     */
+    bool child_failed = false;
+
     /**
      * Function is allowed to call the following methods in this class.
      */
@@ -798,13 +891,58 @@ namespace sandbox
     /**
      * Sends a message to the child process, containing a vtable index and a
      * pointer to the argument frame (a tuple of arguments and space for the
-     * return value).
+     * return value).  Afterwards, runs any asynchronous calls that other
+     * threads queued while this one held `call_lock`.
      */
     void send(int idx, void* ptr);
+    /**
+     * Queues a call in the request ring, containing a vtable index and a
+     * pointer to the argument frame.  Calls `done` when the call has
+     * finished, with a null exception, or with an exception if the child
+     * exited.  `done` is called without any of this object's locks held and
+     * may be called before this returns.
+     *
+     * Calls from several threads are run by the child in batches, each time
+     * that it is given the token, so only one thread waits for the child at a
+     * time.
+     */
+    void send_async(
+      int idx, void* ptr, std::function<void(std::exception_ptr)> done);
+    /**
+     * Pass the token to the child and block until it returns it, handling any
+     * callbacks.  The child makes the synchronous call `idx` if `ptr` is not
+     * null, and then runs any queued asynchronous calls.  Must be called with
+     * `call_lock` held.
+     */
+    void call_child(int idx, void* ptr);
+    /**
+     * If no other thread is doing so, pass the token to the child until it has
+     * seen all of the queued asynchronous calls.
+     */
+    void dispatch_async();
+    /**
+     * Complete the asynchronous calls that the child has finished.
+     */
+    void drain_completions();
+    /**
+     * Fail all of the asynchronous calls in flight with `e`.
+     */
+    void fail_in_flight(std::exception_ptr e);
+    /**
+     * Block until the child has loaded the library, handling any callbacks
+     * that it makes while doing so, and then run any asynchronous calls that
+     * were queued meanwhile.  Throws if the child exits first.
+     */
+    void wait_for_child_load();
+    /**
+     * The part of `wait_for_child_load` that waits for the child.  Must be
+     * called with `call_lock` held.
+     */
+    void load_child();
     /**
      * Instruct the child to exit and block until it does.  The return value is
      * the exit code of the child process.  If the child has already exited,
-     * then this return immediately.
+     * then this return immediately.  Any asynchronous calls still queued fail.
      */
     int wait_for_child_exit();
     /**
@@ -829,6 +967,13 @@ namespace sandbox
      * CallbackDispatcher needs to be able to terminate a running sandbox.
      */
     friend class CallbackDispatcher;
+
+    /**
+     * SandboxPool starts sandboxes before they are needed and must be able to
+     * wait for them to load and check whether their children have exited.
+     */
+    template<typename T>
+    friend class SandboxPool;
   };
 
   /**
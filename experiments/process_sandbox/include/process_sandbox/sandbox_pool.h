@@ -0,0 +1,369 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "sandbox.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sandbox
+{
+  /**
+   * Counters describing the activity of a `SandboxPool`.
+   */
+  struct SandboxPoolStats
+  {
+    /**
+     * The number of sandboxes handed out that had already been started.
+     */
+    size_t warm_acquires = 0;
+
+    /**
+     * The number of sandboxes handed out that had to be started on demand,
+     * because none were ready.
+     */
+    size_t cold_acquires = 0;
+
+    /**
+     * The number of sandboxes that have been started, warm or cold.
+     */
+    size_t started = 0;
+
+    /**
+     * The number of sandboxes that failed to start in the background.
+     */
+    size_t failed_starts = 0;
+
+    /**
+     * The number of sandboxes that have been returned to the pool and
+     * replaced.
+     */
+    size_t recycled = 0;
+
+    /**
+     * The number of sandboxes whose child had exited when they were returned,
+     * or while they were waiting in the pool.
+     */
+    size_t crashed = 0;
+
+    /**
+     * The number of sandboxes that are ready to be handed out.
+     */
+    size_t ready = 0;
+
+    /**
+     * The number of sandboxes that have been handed out and not returned.
+     */
+    size_t in_use = 0;
+  };
+
+  /**
+   * A pool of sandboxes for the same library, started before they are needed.
+   *
+   * Starting a sandbox creates a child process, which maps the shared heap,
+   * drops its privileges, and loads the library, and so takes several
+   * milliseconds.  The pool keeps `size` sandboxes whose children have
+   * finished loading, so that code that wants a fresh sandbox for each request
+   * does not wait for this.
+   *
+   * `T` is the structure that represents an instance of the sandbox, which
+   * must have a `Library` field called `lib` and the functions exported from
+   * it.  Each sandbox is handed out once, with `acquire`, and is replaced when
+   * it is returned.  A sandbox is never reused, because the library's global
+   * state and the child's allocators are not in the shared heap and so the
+   * parent cannot reset them.  A background thread starts the replacements and
+   * destroys returned sandboxes, so neither is on the path of a request.
+   */
+  template<typename T>
+  class SandboxPool
+  {
+  public:
+    /**
+     * The function used to start a sandbox.
+     */
+    using Factory = std::function<std::unique_ptr<T>()>;
+
+    /**
+     * A sandbox handed out by the pool.  This is returned to the pool when it
+     * is destroyed, and must not outlive the pool.
+     */
+    class Lease
+    {
+      /**
+       * The pool that this came from.
+       */
+      SandboxPool* pool = nullptr;
+
+      /**
+       * The sandbox.
+       */
+      std::unique_ptr<T> sandbox;
+
+      /**
+       * The pool constructs leases.
+       */
+      friend class SandboxPool;
+
+      /**
+       * Constructor, called by the pool.
+       */
+      Lease(SandboxPool& p, std::unique_ptr<T>&& s)
+      : pool(&p), sandbox(std::move(s))
+      {}
+
+    public:
+      Lease(Lease&& other) = default;
+      Lease& operator=(Lease&& other)
+      {
+        release();
+        pool = other.pool;
+        sandbox = std::move(other.sandbox);
+        return *this;
+      }
+      Lease(const Lease&) = delete;
+      Lease& operator=(const Lease&) = delete;
+
+      /**
+       * Destructor.  Returns the sandbox to the pool.
+       */
+      ~Lease()
+      {
+        release();
+      }
+
+      /**
+       * Return the sandbox to the pool early.
+       */
+      void release()
+      {
+        if (sandbox)
+        {
+          pool->release(std::move(sandbox));
+        }
+      }
+
+      T& operator*()
+      {
+        return *sandbox;
+      }
+
+      T* operator->()
+      {
+        return sandbox.get();
+      }
+    };
+
+    /**
+     * Constructor.  Starts `count` sandboxes with `factory` and returns once
+     * all of them have loaded the library.
+     */
+    SandboxPool(
+      size_t count, Factory factory = []() { return std::make_unique<T>(); })
+    : size(count), factory(std::move(factory))
+    {
+      for (size_t i = 0; i < size; i++)
+      {
+        ready.push_back(start());
+      }
+      background = std::thread([this]() { run(); });
+    }
+
+    /**
+     * Destructor.  Destroys all of the sandboxes that are not in use.
+     */
+    ~SandboxPool()
+    {
+      {
+        std::lock_guard g(lock);
+        stopping = true;
+      }
+      cv.notify_all();
+      background.join();
+    }
+
+    /**
+     * Hand out a sandbox.  If none is ready, this starts one.  Throws if a
+     * sandbox started here fails to load the library.
+     */
+    Lease acquire()
+    {
+      {
+        std::unique_lock g(lock);
+        while (!ready.empty())
+        {
+          std::unique_ptr<T> sandbox = std::move(ready.front());
+          ready.pop_front();
+          cv.notify_all();
+          if (sandbox->lib.has_child_exited())
+          {
+            counters.crashed++;
+            retired.push_back(std::move(sandbox));
+            continue;
+          }
+          counters.warm_acquires++;
+          counters.in_use++;
+          return {*this, std::move(sandbox)};
+        }
+        counters.cold_acquires++;
+      }
+      std::unique_ptr<T> sandbox = start();
+      std::lock_guard g(lock);
+      counters.in_use++;
+      return {*this, std::move(sandbox)};
+    }
+
+    /**
+     * Returns a snapshot of the pool's counters.
+     */
+    SandboxPoolStats stats()
+    {
+      std::lock_guard g(lock);
+      SandboxPoolStats s = counters;
+      s.ready = ready.size();
+      return s;
+    }
+
+  private:
+    /**
+     * The number of sandboxes to keep ready.
+     */
+    const size_t size;
+
+    /**
+     * The function used to start sandboxes.
+     */
+    Factory factory;
+
+    /**
+     * Lock protecting the rest of the state of the pool.
+     */
+    std::mutex lock;
+
+    /**
+     * Condition variable used to wake the background thread when there is
+     * something for it to do.
+     */
+    std::condition_variable cv;
+
+    /**
+     * Sandboxes that are ready to be handed out.
+     */
+    std::deque<std::unique_ptr<T>> ready;
+
+    /**
+     * Sandboxes that have been returned and are waiting to be destroyed.
+     */
+    std::vector<std::unique_ptr<T>> retired;
+
+    /**
+     * The counters reported by `stats`.
+     */
+    SandboxPoolStats counters;
+
+    /**
+     * Set when the pool is being destroyed.
+     */
+    bool stopping = false;
+
+    /**
+     * The thread that starts and destroys sandboxes.
+     */
+    std::thread background;
+
+    /**
+     * Start a sandbox and wait for its child to load the library.
+     */
+    std::unique_ptr<T> start()
+    {
+      std::unique_ptr<T> sandbox = factory();
+      sandbox->lib.wait_for_child_load();
+      std::lock_guard g(lock);
+      counters.started++;
+      return sandbox;
+    }
+
+    /**
+     * Take back a sandbox that was handed out, to be destroyed and replaced
+     * by the background thread.
+     */
+    void release(std::unique_ptr<T>&& sandbox)
+    {
+      {
+        std::lock_guard g(lock);
+        counters.in_use--;
+        if (sandbox->lib.has_child_exited())
+        {
+          counters.crashed++;
+        }
+        else
+        {
+          counters.recycled++;
+        }
+        retired.push_back(std::move(sandbox));
+      }
+      cv.notify_all();
+    }
+
+    /**
+     * The background thread.  Starting replacements takes priority over
+     * destroying returned sandboxes, because a request may be waiting for
+     * them.
+     */
+    void run()
+    {
+      std::unique_lock g(lock);
+      while (true)
+      {
+        if (!stopping && (ready.size() < size))
+        {
+          g.unlock();
+          std::unique_ptr<T> sandbox;
+          try
+          {
+            sandbox = start();
+          }
+          catch (std::exception&)
+          {}
+          g.lock();
+          if (sandbox)
+          {
+            ready.push_back(std::move(sandbox));
+          }
+          else
+          {
+            // Don't spin if the library cannot be loaded.
+            counters.failed_starts++;
+            cv.wait_for(g, std::chrono::milliseconds(100));
+          }
+        }
+        else if (!retired.empty())
+        {
+          std::unique_ptr<T> sandbox = std::move(retired.back());
+          retired.pop_back();
+          g.unlock();
+          sandbox.reset();
+          g.lock();
+        }
+        else if (stopping)
+        {
+          break;
+        }
+        else
+        {
+          cv.wait(g);
+        }
+      }
+      std::deque<std::unique_ptr<T>> idle = std::move(ready);
+      g.unlock();
+      idle.clear();
+    }
+  };
+}
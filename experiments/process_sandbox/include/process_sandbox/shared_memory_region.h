@@ -6,10 +6,172 @@
 #  include <pthread.h>
 #endif
 
+#include "callback_numbers.h"
+
+#include <atomic>
 #include <snmalloc/snmalloc_core.h>
 
 namespace sandbox
 {
+  /**
+   * A single-producer, single-consumer ring buffer in the shared memory
+   * region.
+   *
+   * Both the head and the tail are writeable by the other side, so neither
+   * side trusts them.  Each side instead keeps its own copy of the index that
+   * it owns (the tail for the producer, the head for the consumer) in memory
+   * that the other side cannot write, and passes it to `push` or `drain`.
+   * The shared copies are only hints, and corrupting them can only cause a
+   * side to lose or reprocess entries, never to read or write outside the
+   * ring.
+   */
+  template<typename T, uint32_t Size>
+  class SharedRing
+  {
+    static_assert(
+      snmalloc::bits::is_pow2(Size), "Ring size must be a power of two");
+
+    /**
+     * The index of the next entry to be consumed.  Written by the consumer.
+     */
+    std::atomic<uint32_t> head = 0;
+
+    /**
+     * The index of the next entry to be produced.  Written by the producer.
+     */
+    std::atomic<uint32_t> tail = 0;
+
+    /**
+     * The entries.
+     */
+    T entries[Size];
+
+  public:
+    /**
+     * Push `value` into the ring.  `producer_tail` is the producer's copy of
+     * the tail.  Returns false if the ring is full.
+     */
+    bool push(uint32_t& producer_tail, const T& value)
+    {
+      if (producer_tail - head.load(std::memory_order_acquire) >= Size)
+      {
+        return false;
+      }
+      entries[producer_tail % Size] = value;
+      producer_tail++;
+      tail.store(producer_tail, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * Pop the next entry from the ring into `value`.  `consumer_head` is the
+     * consumer's copy of the head.  Returns false if the ring is empty.
+     */
+    bool pop(uint32_t& consumer_head, T& value)
+    {
+      uint32_t t = tail.load(std::memory_order_acquire);
+      // Stop if the ring is empty, or if the tail is not ahead of the head by
+      // at most the size of the ring, which can only happen if it has been
+      // corrupted.
+      if ((t == consumer_head) || (t - consumer_head > Size))
+      {
+        return false;
+      }
+      value = entries[consumer_head % Size];
+      consumer_head++;
+      head.store(consumer_head, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * Pop entries from the ring and pass each one to `fn`, until the ring is
+     * empty or `Size` entries have been popped.  `consumer_head` is the
+     * consumer's copy of the head.  Returns the number of entries popped.
+     *
+     * The head is advanced before `fn` is called, so `fn` may drain the ring
+     * recursively.
+     */
+    template<typename F>
+    uint32_t drain(uint32_t& consumer_head, F&& fn)
+    {
+      uint32_t count = 0;
+      T value;
+      for (; (count < Size) && pop(consumer_head, value); count++)
+      {
+        fn(value);
+      }
+      return count;
+    }
+  };
+
+  /**
+   * A request to call a sandboxed function, in the call ring.
+   */
+  struct CallRequest
+  {
+    /**
+     * The identifier of the call, which the child returns in the completion
+     * ring when the call has finished.
+     */
+    uint32_t id;
+
+    /**
+     * The index of the function to call.
+     */
+    int function_index;
+
+    /**
+     * A pointer to the argument frame, in the shared memory range.
+     */
+    void* msg_buffer;
+  };
+
+  /**
+   * Mailbox for callbacks from the child that do not pass a file descriptor.
+   * These avoid the system calls to send and receive each message through
+   * the socket.  The child serialises callbacks, so there is only ever one in
+   * progress at each callback depth, and each side reads the mailbox before
+   * the other can reuse it for a deeper callback.
+   *
+   * The child can write to the mailbox at any time, so the parent copies the
+   * request out before checking it, and the handler copies the payload out in
+   * the same way as for a request from the socket.
+   */
+  struct CallbackMailbox
+  {
+    /**
+     * Set by the child when it has written a request, and cleared by the
+     * parent when it reads it.
+     */
+    std::atomic<bool> has_request = false;
+
+    /**
+     * The kind of the callback, as `CallbackRequest::kind`.
+     */
+    CallbackKind kind;
+
+    /**
+     * The size of the payload, as `CallbackRequest::size`.
+     */
+    size_t size;
+
+    /**
+     * The address of the payload, as `CallbackRequest::data`.
+     */
+    uintptr_t data;
+
+    /**
+     * Set by the parent if the response to the last callback is on the
+     * socket, because it is accompanied by a file descriptor.
+     */
+    std::atomic<bool> response_on_socket = false;
+
+    /**
+     * The response to the last callback, if it is not on the socket.
+     */
+    uintptr_t response;
+  };
+
   /**
    * Class representing a view of a shared memory region.  This provides both
    * the parent and child views of the region.
@@ -33,8 +195,9 @@ namespace sandbox
      */
     std::atomic<bool> should_exit = false;
     /**
-     * The index of the function currently being called.  This interface is not
-     * currently reentrant.
+     * The index of the function currently being called synchronously.  This
+     * interface is not currently reentrant.  Asynchronous calls go through
+     * `requests` instead.
      */
     int function_index;
     /**
@@ -49,6 +212,49 @@ namespace sandbox
      */
     snmalloc::RemoteAllocator allocator_state;
 
+    /**
+     * The maximum number of worker threads that the child will start.  Each
+     * has its stack in the sandbox's heap.
+     */
+    static constexpr uint32_t max_worker_threads = 16;
+
+    /**
+     * The number of threads that the child starts to run asynchronous calls,
+     * in addition to the thread that runs synchronous calls.  This is set by
+     * the parent before the child starts.
+     */
+    uint32_t worker_threads = 0;
+
+    /**
+     * Whether the child should spin before sleeping when it waits for the
+     * token, see `platform::AdaptiveSpin`.  This is set by the parent, because
+     * the child cannot find the number of cores without a callback.
+     */
+    bool spin_on_wait = false;
+
+    /**
+     * The number of entries in each of the call rings.  This is also the
+     * maximum number of asynchronous calls that can be in flight.
+     */
+    static constexpr uint32_t call_ring_size = 64;
+
+    /**
+     * Asynchronous calls queued by the parent.  The child runs all of the
+     * queued calls each time that it is given the token, after any
+     * synchronous call.
+     */
+    SharedRing<CallRequest, call_ring_size> requests;
+
+    /**
+     * The identifiers of asynchronous calls that the child has finished.
+     */
+    SharedRing<uint32_t, call_ring_size> completions;
+
+    /**
+     * The mailbox for callbacks that do not pass a file descriptor.
+     */
+    CallbackMailbox callback_mailbox;
+
     /**
      * A token that is logically passed from the parent to the child and back
      * again, where each hands control to the other.
@@ -75,9 +281,8 @@ namespace sandbox
        */
       std::atomic<bool> is_child_loaded = false;
       /**
-       * The current depth of callbacks.
-       *
-       * FIXME: Rentrancy with multiple threads in the child is not working.
+       * The current depth of callbacks.  Callbacks from different threads in
+       * the child are serialised, so there is only one stack of them.
        */
       std::atomic<int> callback_depth = 0;
     } token;
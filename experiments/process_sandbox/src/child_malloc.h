@@ -89,6 +89,12 @@ namespace sandbox
     inline static snmalloc::Pipe<PalRange, snmalloc::SmallBuddyRange>
       metadata_range;
 
+    /**
+     * Lock protecting `metadata_range`, which may be used by several threads
+     * at once.
+     */
+    inline static snmalloc::FlagWord metadata_lock;
+
   public:
     /**
      * Expose a PAL that doesn't do allocation.
@@ -9,9 +9,12 @@
 #include "process_sandbox/sandbox.h"
 #include "process_sandbox/shared_memory_region.h"
 
+#include <algorithm>
+#include <condition_variable>
 #include <dlfcn.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <mutex>
 #include <pthread.h>
 #include <signal.h>
 #include <stdarg.h>
@@ -214,6 +217,12 @@ namespace
    */
   snmalloc::Pipe<SharedMemoryRange, snmalloc::SmallBuddyRange> allocator_range;
 
+  /**
+   * Lock protecting `allocator_range`, which is used to allocate the
+   * allocator for each thread.
+   */
+  snmalloc::FlagWord allocator_range_lock;
+
 }
 
 void SnmallocGlobals::ensure_init() noexcept
@@ -236,9 +245,13 @@ namespace sandbox
     SnmallocGlobals::Backend::alloc_chunk(
       SnmallocGlobals::LocalState&, size_t size, uintptr_t ras)
   {
-    auto* ms = new (
-      metadata_range.alloc_range(sizeof(SnmallocGlobals::Backend::SlabMetadata))
-        .unsafe_ptr()) SnmallocGlobals::Backend::SlabMetadata();
+    snmalloc::capptr::Arena<void> meta;
+    {
+      FlagLock g(metadata_lock);
+      meta = metadata_range.alloc_range(
+        sizeof(SnmallocGlobals::Backend::SlabMetadata));
+    }
+    auto* ms = new (meta.unsafe_ptr()) SnmallocGlobals::Backend::SlabMetadata();
     auto arena = snmalloc::capptr::Arena<void>::unsafe_from(
       reinterpret_cast<void*>(requestHostService(
         AllocChunk,
@@ -247,6 +260,7 @@ namespace sandbox
         ras)));
     if (arena == nullptr)
     {
+      FlagLock g(metadata_lock);
       metadata_range.dealloc_range(
         snmalloc::capptr::Arena<void>::unsafe_from(ms),
         sizeof(SnmallocGlobals::Backend::SlabMetadata));
@@ -267,9 +281,12 @@ namespace sandbox
     size_t size)
   {
     auto addr = snmalloc::capptr::Arena<void>::unsafe_from(start.unsafe_ptr());
-    metadata_range.dealloc_range(
-      snmalloc::capptr::Arena<void>::unsafe_from(&meta_common),
-      sizeof(SnmallocGlobals::Backend::SlabMetadata));
+    {
+      FlagLock g(metadata_lock);
+      metadata_range.dealloc_range(
+        snmalloc::capptr::Arena<void>::unsafe_from(&meta_common),
+        sizeof(SnmallocGlobals::Backend::SlabMetadata));
+    }
     requestHostService(
       DeallocChunk, addr.unsafe_uintptr(), static_cast<uintptr_t>(size));
   }
@@ -279,6 +296,7 @@ namespace sandbox
     snmalloc::CoreAllocator<sandbox::SnmallocGlobals>>(LocalState*, size_t size)
   {
     size = snmalloc::bits::next_pow2(size);
+    FlagLock g(allocator_range_lock);
     return allocator_range.alloc_range(size);
   }
 
@@ -296,6 +314,176 @@ namespace
    */
   void (*sandbox_invoke)(int, void*);
 
+  /**
+   * The child's copies of its indexes into the call rings, see `SharedRing`.
+   * These are not in shared memory, so the parent cannot modify them.  They
+   * are protected by `queue_lock`, because any thread may run queued calls.
+   */
+  uint32_t request_head = 0;
+  uint32_t completion_tail = 0;
+
+  /**
+   * Lock protecting the child's ends of the call rings and the state of the
+   * worker threads.
+   */
+  std::mutex queue_lock;
+
+  /**
+   * The state of the worker threads.
+   */
+  struct WorkerPool
+  {
+    /**
+     * Condition variable that the worker threads wait on for a new batch.
+     */
+    std::condition_variable batch_started;
+
+    /**
+     * Condition variable that the thread that started a batch waits on for
+     * the worker threads to finish it.
+     */
+    std::condition_variable batch_finished;
+
+    /**
+     * The number of batches that the worker threads have been asked to run.
+     */
+    uint64_t batch = 0;
+
+    /**
+     * The number of worker threads that have not yet finished the current
+     * batch.
+     */
+    uint32_t busy = 0;
+
+    /**
+     * The number of worker threads.
+     */
+    uint32_t count = 0;
+  };
+
+  /**
+   * The worker threads, or null if there are none.  This is never
+   * deallocated: `exit` runs static destructors, and destroying a condition
+   * variable blocks while the worker threads are waiting on it.
+   */
+  WorkerPool* workers = nullptr;
+
+  /**
+   * Invoke the function at index `idx` in the loaded library's vtable, with
+   * the argument frame `buf`.
+   */
+  void invoke(int idx, void* buf)
+  {
+    try
+    {
+      if ((buf != nullptr) && (sandbox_invoke != nullptr))
+        sandbox_invoke(idx, buf);
+    }
+    catch (...)
+    {
+      // FIXME: Report error in some useful way.
+      SANDBOX_INVARIANT(0, "Uncaught exception");
+    }
+  }
+
+  /**
+   * Run asynchronous calls that the parent has queued on this thread, and
+   * report each one in the completion ring when it finishes, until the ring
+   * is empty.  Several threads may do this at once.
+   */
+  void run_queued_calls()
+  {
+    std::unique_lock g(queue_lock);
+    CallRequest req;
+    while (shared->requests.pop(request_head, req))
+    {
+      g.unlock();
+      invoke(req.function_index, req.msg_buffer);
+      g.lock();
+      // The parent never has more calls in flight than the ring holds.
+      bool pushed = shared->completions.push(completion_tail, req.id);
+      SANDBOX_INVARIANT(pushed, "Completion ring is full");
+    }
+  }
+
+  /**
+   * Run the queued asynchronous calls on this thread and all of the worker
+   * threads, and return when all of the calls that any of them started have
+   * finished.
+   */
+  void run_batch()
+  {
+    if (workers == nullptr)
+    {
+      run_queued_calls();
+      return;
+    }
+    std::unique_lock g(queue_lock);
+    workers->batch++;
+    workers->busy = workers->count;
+    g.unlock();
+    workers->batch_started.notify_all();
+    run_queued_calls();
+    g.lock();
+    workers->batch_finished.wait(g, []() { return workers->busy == 0; });
+  }
+
+  /**
+   * The body of each worker thread.  Runs queued calls whenever a batch is
+   * started.
+   */
+  void worker()
+  {
+    uint64_t last_batch = 0;
+    std::unique_lock g(queue_lock);
+    while (true)
+    {
+      workers->batch_started.wait(
+        g, [&]() { return workers->batch != last_batch; });
+      last_batch = workers->batch;
+      g.unlock();
+      run_queued_calls();
+      g.lock();
+      if (--workers->busy == 0)
+      {
+        workers->batch_finished.notify_one();
+      }
+    }
+  }
+
+  /**
+   * Start `count` worker threads.  Like the thread that runs the run loop,
+   * each has its stack in the shared region.
+   */
+  void start_workers(uint32_t count, size_t stack_size)
+  {
+    if (count == 0)
+    {
+      return;
+    }
+    workers = new WorkerPool();
+    for (uint32_t i = 0; i < count; i++)
+    {
+      pthread_t thread;
+      pthread_attr_t attrs;
+      pthread_attr_init(&attrs);
+      pthread_attr_setstack(&attrs, malloc(stack_size), stack_size);
+      int ret = pthread_create(
+        &thread,
+        &attrs,
+        [](void*) -> void* {
+          worker();
+          return nullptr;
+        },
+        nullptr);
+      SANDBOX_INVARIANT(ret == 0, "Failed to start worker thread: {}", ret);
+      pthread_attr_destroy(&attrs);
+      pthread_detach(thread);
+      std::lock_guard g(queue_lock);
+      workers->count++;
+    }
+  }
+
   /**
    * The run loop.  Takes the public interface of this library (effectively,
    * the library's vtable) as an argument.  Exits when the callback depth
@@ -307,6 +495,7 @@ namespace
   __attribute__((used)) void runloop(int callback_depth = 0)
   {
     int new_depth;
+    sandbox::platform::AdaptiveSpin spin(shared->spin_on_wait);
     do
     {
       // If `wait` spuriously fails, try again unless the parent has asked us
@@ -317,22 +506,23 @@ namespace
         {
           exit(0);
         }
-      } while (!shared->token.child.wait(INT_MAX));
+      } while (!spin.wait(shared->token.child, INT_MAX));
       SANDBOX_DEBUG_INVARIANT(
         shared->token.is_child_executing,
         "Child is executing when the parent thinks is is not");
       int idx = shared->function_index;
       void* buf = shared->msg_buffer;
       shared->msg_buffer = nullptr;
-      try
+      invoke(idx, buf);
+      // Calls from callbacks are run on the thread that made the callback,
+      // any others are shared with the worker threads.
+      if (callback_depth == 0)
       {
-        if ((buf != nullptr) && (sandbox_invoke != nullptr))
-          sandbox_invoke(idx, buf);
+        run_batch();
       }
-      catch (...)
+      else
       {
-        // FIXME: Report error in some useful way.
-        SANDBOX_INVARIANT(0, "Uncaught exception");
+        run_queued_calls();
       }
       new_depth = shared->token.callback_depth;
       // Wake up the parent if it's expecting a wakeup for this callback depth.
@@ -431,6 +621,15 @@ namespace
    */
   Socket callbackSocket;
 
+  /**
+   * Lock held for the duration of a callback.  The parent handles callbacks
+   * one at a time, matching each to the caller by its depth, so callbacks
+   * from different threads must not overlap.  This is recursive because the
+   * parent may call back into the sandbox while handling a callback, on the
+   * thread that made it, which may then make another callback.
+   */
+  std::recursive_mutex callback_lock;
+
   /**
    * Invoke a callback.  This takes the kind of callback, the data to be sent,
    * and the file descriptor to send as arguments.  The file descriptor may be
@@ -445,23 +644,40 @@ namespace
   std::pair<uintptr_t, Handle>
   callback(sandbox::CallbackKind k, const void* buffer, size_t size, int fd)
   {
-    Handle out_fd(fd);
-    CallbackRequest req{k, size, reinterpret_cast<uintptr_t>(buffer)};
-    if (!callbackSocket.blocking_send(req, out_fd))
+    std::lock_guard g(callback_lock);
+    auto& mailbox = shared->callback_mailbox;
+    // Only file descriptors need the socket.
+    if (fd < 0)
     {
-      snmalloc::report_fatal_error(
-        "Sandbox failed to write callback request (Callback {}, {} bytes to "
-        "file descriptor {})",
-        static_cast<size_t>(k),
-        size,
-        fd);
+      mailbox.kind = k;
+      mailbox.size = size;
+      mailbox.data = reinterpret_cast<uintptr_t>(buffer);
+      mailbox.has_request.store(true, std::memory_order_release);
+    }
+    else
+    {
+      Handle out_fd(fd);
+      CallbackRequest req{k, size, reinterpret_cast<uintptr_t>(buffer)};
+      if (!callbackSocket.blocking_send(req, out_fd))
+      {
+        snmalloc::report_fatal_error(
+          "Sandbox failed to write callback request (Callback {}, {} bytes to "
+          "file descriptor {})",
+          static_cast<size_t>(k),
+          size,
+          fd);
+      }
+      out_fd.take();
     }
-    out_fd.take();
     int depth = ++shared->token.callback_depth;
     shared->token.is_child_executing = false;
     shared->token.parent.wake();
     runloop(depth);
     Handle in_fd;
+    if (!mailbox.response_on_socket.load(std::memory_order_acquire))
+    {
+      return {mailbox.response, std::move(in_fd)};
+    }
     CallbackResponse response;
     if (!callbackSocket.blocking_receive(response, in_fd))
     {
@@ -1112,10 +1328,14 @@ int main()
   SANDBOX_INVARIANT(
     sandbox_invoke, "Sandbox invoke invoke function not found {}", dlerror());
 
+  static constexpr size_t stack_size = 8 * 1024 * 1024;
+  start_workers(
+    std::min(shared->worker_threads, SharedMemoryRegion::max_worker_threads),
+    stack_size);
+
   shared->token.is_child_executing = false;
   shared->token.is_child_loaded = true;
 
-  static constexpr size_t stack_size = 8 * 1024 * 1024;
   void* stack = malloc(stack_size);
   // Enter the run loop, waiting for calls from trusted code.
   // We do this in a new thread so that our stack can be in the shared region.
@@ -1,6 +1,7 @@
 // Copyright Microsoft and Project Verona Contributors.
 // SPDX-License-Identifier: MIT
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <functional>
@@ -662,9 +663,16 @@ namespace sandbox
     {
       CallbackRequest req;
       platform::Handle in_fd;
+      auto& mailbox = lib.shared_mem->callback_mailbox;
+      // Requests that do not pass a file descriptor are in the mailbox.  Copy
+      // the request out once, the child may modify the mailbox at any time.
+      if (mailbox.has_request.exchange(false, std::memory_order_acquire))
+      {
+        req = {mailbox.kind, mailbox.size, mailbox.data};
+      }
       // This should not block, but it can if the sandbox doesn't write
       // anything into the socket.
-      if (!socket.nonblocking_receive(req, in_fd))
+      else if (!socket.nonblocking_receive(req, in_fd))
       {
         return;
       }
@@ -674,6 +682,14 @@ namespace sandbox
       {
         ret = handlers[req.kind]->invoke(lib, req, std::move(in_fd));
       }
+      // Only file descriptors need the socket.
+      if (!ret.handle.is_valid())
+      {
+        mailbox.response = static_cast<uintptr_t>(ret.integer);
+        mailbox.response_on_socket.store(false, std::memory_order_release);
+        return;
+      }
+      mailbox.response_on_socket.store(true, std::memory_order_release);
       if (!socket.nonblocking_send(ret.integer, ret.handle))
       {
         lib.terminate();
@@ -862,12 +878,14 @@ namespace sandbox
     _exit(EXIT_FAILURE);
   }
 
-  Library::Library(const char* library_name, size_t size)
+  Library::Library(
+    const char* library_name, size_t size, uint32_t worker_threads)
   : shm(snmalloc::bits::next_pow2_bits(size << 30)),
     memory_provider(
       pointer_offset(shm.get_base(), sizeof(SharedMemoryRegion)),
       shm.get_size() - sizeof(SharedMemoryRegion)),
-    callback_dispatcher(std::make_unique<CallbackDispatcher>())
+    callback_dispatcher(std::make_unique<CallbackDispatcher>()),
+    call_spin(std::thread::hardware_concurrency() > 1)
   {
     void* shm_base = shm.get_base();
     // Allocate the shared memory region and set its memory provider to use all
@@ -875,6 +893,9 @@ namespace sandbox
     shared_mem = new (shm_base) SharedMemoryRegion();
     shared_mem->start = shm_base;
     shared_mem->end = pointer_offset(shm.get_base(), shm.get_size());
+    shared_mem->worker_threads =
+      std::min(worker_threads, SharedMemoryRegion::max_worker_threads);
+    shared_mem->spin_on_wait = call_spin.is_enabled();
 
     // Create a pair of sockets that we can use to
     auto malloc_rpc_sockets = platform::SocketPair::create();
@@ -933,29 +954,194 @@ namespace sandbox
 
   void Library::send(int idx, void* ptr)
   {
-    // If this is the first call, we need to handle callbacks while the sandbox
-    // initialises
-    if (is_first_call)
     {
-      while (!shared_mem->token.is_child_loaded)
+      std::lock_guard g(call_lock);
+      try
       {
-        if (shared_mem->token.callback_depth > 0)
+        call_child(idx, ptr);
+      }
+      catch (...)
+      {
+        // The child may have taken queued asynchronous calls with it.
+        if (has_child_exited())
         {
-          shared_mem->token.parent.wait(INT_MAX);
-          callback_dispatcher->handle(*this);
-          shared_mem->token.callback_depth--;
-          shared_mem->token.is_child_executing = true;
-          shared_mem->token.child.wake();
+          fail_in_flight(std::current_exception());
         }
-        else
+        throw;
+      }
+      drain_completions();
+    }
+    // Asynchronous calls queued while we held the lock were left for us to
+    // run, but the child may have emptied the ring before they arrived.
+    dispatch_async();
+  }
+
+  void Library::send_async(
+    int idx, void* ptr, std::function<void(std::exception_ptr)> done)
+  {
+    while (true)
+    {
+      {
+        std::unique_lock g(ring_lock);
+        if (child_failed)
+        {
+          g.unlock();
+          done(std::make_exception_ptr(
+            std::runtime_error("Sandboxed library terminated abnormally")));
+          return;
+        }
+        auto& call =
+          in_flight[request_tail % SharedMemoryRegion::call_ring_size];
+        uint32_t id = request_tail;
+        if (
+          !call.active &&
+          shared_mem->requests.push(request_tail, {id, idx, ptr}))
         {
-          std::this_thread::sleep_for(1ms);
+          call.id = id;
+          call.active = true;
+          call.done = std::move(done);
+          break;
         }
       }
+      // The ring is full, run the queued calls and try again.
+      dispatch_async();
+      std::this_thread::yield();
+    }
+    dispatch_async();
+  }
+
+  void Library::dispatch_async()
+  {
+    auto has_pending = [&]() {
+      std::lock_guard g(ring_lock);
+      return dispatched_tail != request_tail;
+    };
+    // If another thread holds the call lock then it will see any calls that
+    // were queued before it releases the lock, so there is no need to wait
+    // for it.
+    while (has_pending())
+    {
+      std::unique_lock g(call_lock, std::try_to_lock);
+      if (!g.owns_lock())
+      {
+        return;
+      }
+      try
+      {
+        while (has_pending())
+        {
+          call_child(0, nullptr);
+          drain_completions();
+        }
+      }
+      catch (std::runtime_error&)
+      {
+        fail_in_flight(std::current_exception());
+        return;
+      }
+    }
+  }
+
+  void Library::drain_completions()
+  {
+    // The completion functions free the argument frames, so they are called
+    // after releasing the ring lock.
+    std::vector<std::function<void(std::exception_ptr)>> finished;
+    {
+      std::lock_guard g(ring_lock);
+      shared_mem->completions.drain(completion_head, [&](uint32_t id) {
+        auto& call = in_flight[id % SharedMemoryRegion::call_ring_size];
+        // The child can write anything into the ring, so ignore anything
+        // that is not a call in flight.
+        if (call.active && (call.id == id))
+        {
+          call.active = false;
+          finished.push_back(std::move(call.done));
+        }
+      });
+    }
+    for (auto& done : finished)
+    {
+      done(nullptr);
+    }
+  }
+
+  void Library::fail_in_flight(std::exception_ptr e)
+  {
+    std::vector<std::function<void(std::exception_ptr)>> failed;
+    {
+      std::lock_guard g(ring_lock);
+      for (auto& call : in_flight)
+      {
+        if (call.active)
+        {
+          call.active = false;
+          failed.push_back(std::move(call.done));
+        }
+      }
+      dispatched_tail = request_tail;
+      child_failed = true;
+    }
+    for (auto& done : failed)
+    {
+      done(e);
+    }
+  }
+
+  void Library::wait_for_child_load()
+  {
+    {
+      std::lock_guard g(call_lock);
+      load_child();
+    }
+    // Run any asynchronous calls that were queued while we held the lock.
+    dispatch_async();
+  }
+
+  void Library::load_child()
+  {
+    if (!is_first_call)
+    {
+      return;
+    }
+    // Handle callbacks while the sandbox initialises.
+    while (!shared_mem->token.is_child_loaded)
+    {
+      if (shared_mem->token.callback_depth > 0)
+      {
+        shared_mem->token.parent.wait(INT_MAX);
+        callback_dispatcher->handle(*this);
+        shared_mem->token.callback_depth--;
+        shared_mem->token.is_child_executing = true;
+        shared_mem->token.child.wake();
+      }
+      else if (has_child_exited())
+      {
+        throw std::runtime_error("Sandboxed library failed to load");
+      }
+      else
+      {
+        std::this_thread::sleep_for(1ms);
+      }
+    }
+    is_first_call = false;
+  }
+
+  void Library::call_child(int idx, void* ptr)
+  {
+    // If this is the first call, we need to wait for the sandbox to initialise
+    if (is_first_call)
+    {
+      load_child();
     }
     int callback_depth = shared_mem->token.callback_depth.load();
     shared_mem->function_index = idx;
     shared_mem->msg_buffer = ptr;
+    {
+      // The child runs every call queued before it is woken.
+      std::lock_guard g(ring_lock);
+      dispatched_tail = request_tail;
+    }
     assert(!shared_mem->token.is_child_executing);
     shared_mem->token.is_child_executing = true;
     shared_mem->token.child.wake();
@@ -968,7 +1154,7 @@ namespace sandbox
     do
     {
       handled_callback = false;
-      while (!shared_mem->token.parent.wait(100))
+      while (!call_spin.wait(shared_mem->token.parent, 100))
       {
         if (has_child_exited())
         {
@@ -1006,15 +1192,21 @@ namespace sandbox
   int Library::wait_for_child_exit()
   {
     auto exit_status = child_proc->exit_status();
-    if (exit_status.has_exited)
+    int exit_code = exit_status.exit_code;
+    if (!exit_status.has_exited)
     {
-      return exit_status.exit_code;
+      std::lock_guard g(call_lock);
+      shared_mem->should_exit = true;
+      assert(!shared_mem->token.is_child_executing);
+      shared_mem->token.is_child_executing = true;
+      shared_mem->token.child.wake();
+      exit_code = child_proc->wait_for_exit().exit_code;
     }
-    shared_mem->should_exit = true;
-    assert(!shared_mem->token.is_child_executing);
-    shared_mem->token.is_child_executing = true;
-    shared_mem->token.child.wake();
-    return child_proc->wait_for_exit().exit_code;
+    // Asynchronous calls that the child did not run before exiting, including
+    // any queued while we held the lock, can no longer run.
+    fail_in_flight(std::make_exception_ptr(
+      std::runtime_error("Sandboxed library has exited")));
+    return exit_code;
   }
 
   void* Library::alloc_in_sandbox(size_t bytes, size_t count)
@@ -1025,10 +1217,12 @@ namespace sandbox
     {
       return nullptr;
     }
+    std::lock_guard g(alloc_lock);
     return allocator->alloc(sz);
   }
   void Library::dealloc_in_sandbox(void* ptr)
   {
+    std::lock_guard g(alloc_lock);
     allocator->dealloc(ptr);
   }
 
@@ -5,6 +5,7 @@
 #include "process_sandbox/filetree.h"
 #include "process_sandbox/sandbox.h"
 
+#include <chrono>
 #include <stdio.h>
 
 using namespace sandbox;
@@ -20,8 +21,35 @@ struct VFSSandbox
   Library lib = {SANDBOX_LIBRARY};
   decltype(make_sandboxed_function<int(bool)>(lib)) test =
     make_sandboxed_function<int(bool)>(lib);
+  decltype(make_sandboxed_function<int(int)>(lib)) access_loop =
+    make_sandboxed_function<int(int)>(lib);
+  decltype(make_sandboxed_function<int(int)>(lib)) open_loop =
+    make_sandboxed_function<int(int)>(lib);
 };
 
+/**
+ * Run `loop` in the sandbox for `count` iterations and report the time for
+ * each.  Each iteration makes a callback whether or not it succeeds, so this
+ * reports the number that succeeded but does not check it.
+ */
+template<typename Fn>
+void benchmark(const char* name, Fn& loop, int count)
+{
+  auto start = std::chrono::steady_clock::now();
+  int ret = loop(count);
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count();
+  fprintf(
+    stderr,
+    "%d %s calls (%d succeeded) in %lldns (%lldns per call)\n",
+    count,
+    name,
+    ret,
+    static_cast<long long>(ns),
+    static_cast<long long>(ns / count));
+}
+
 int main()
 {
   VFSSandbox sandbox;
@@ -44,12 +72,18 @@ int main()
   };
   fprintf(stderr, "Indirect syscall\n");
   test(false);
+  // The request for each of these is in the shared-memory mailbox.  The
+  // response for `access` is too, but the one for `open` passes a file
+  // descriptor and so is on the socket.
+  benchmark("open", sandbox.open_loop, 10000);
   // The no-op sandbox doesn't actually do any sandboxing so raw system calls
-  // will work.  Skip the test that they're correctly intercepted.
+  // will work.  Skip the test that they're correctly intercepted, and the
+  // benchmark of `access`, which is only emulated if it is intercepted.
   if constexpr (!std::is_same_v<platform::Sandbox, platform::SandboxNoOp>)
   {
     fprintf(stderr, "Direct syscall\n");
     test(true);
+    benchmark("access", sandbox.access_loop, 10000);
   }
   return 0;
 }
@@ -0,0 +1,103 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Test for mixing synchronous and asynchronous sandbox calls.
+ *
+ * Several threads make synchronous and asynchronous calls into one sandbox at
+ * the same time, starting with a fresh sandbox in each round so that the
+ * first calls also race with the child loading the library.  An asynchronous
+ * call queued while another thread holds the call lock is run by that thread,
+ * so checks that every future completes, with the right answer, rather than
+ * waiting for some later call.
+ */
+
+#include "process_sandbox/cxxsandbox.h"
+#include "process_sandbox/sandbox.h"
+
+#include <chrono>
+#include <future>
+#include <stdio.h>
+#include <thread>
+
+using namespace sandbox;
+using namespace std::chrono_literals;
+
+int sum(int, int);
+
+/**
+ * The structure that represents an instance of the sandbox.
+ */
+struct AddSandbox
+{
+  /**
+   * The library that defines the functions exposed by this sandbox.
+   */
+  Library lib = {SANDBOX_LIBRARY};
+#define EXPORTED_FUNCTION(public_name, private_name) \
+  decltype(make_sandboxed_function<decltype(private_name)>(lib)) public_name = \
+    make_sandboxed_function<decltype(private_name)>(lib);
+  EXPORTED_FUNCTION(sum, ::sum)
+};
+
+/**
+ * Make `calls` calls from thread `thread`, alternating between synchronous
+ * calls and batches of asynchronous calls, and check the results.
+ */
+void run_thread(AddSandbox& sandbox, int thread, int calls)
+{
+  std::vector<std::pair<int, std::future<int>>> futures;
+  for (int i = 0; i < calls; i++)
+  {
+    int a = thread * calls + i;
+    if ((i % 4) == (thread % 4))
+    {
+      int ret = sandbox.sum(a, 1);
+      SANDBOX_INVARIANT(ret == (a + 1), "{} + 1 == {}", a, ret);
+    }
+    else
+    {
+      futures.emplace_back(a, sandbox.sum.async(a, 1));
+    }
+  }
+  for (auto& [a, future] : futures)
+  {
+    SANDBOX_INVARIANT(
+      future.wait_for(10s) == std::future_status::ready,
+      "Asynchronous call {} + 1 from thread {} never completed",
+      a,
+      thread);
+    int ret = future.get();
+    SANDBOX_INVARIANT(ret == (a + 1), "{} + 1 == {}", a, ret);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  int thread_count = (argc > 1) ? atoi(argv[1]) : 4;
+  int rounds = (argc > 2) ? atoi(argv[2]) : 8;
+  int calls = (argc > 3) ? atoi(argv[3]) : 256;
+
+  try
+  {
+    for (int r = 0; r < rounds; r++)
+    {
+      AddSandbox sandbox;
+      std::vector<std::thread> threads;
+      for (int i = 0; i < thread_count; i++)
+      {
+        threads.emplace_back([&, i]() { run_thread(sandbox, i, calls); });
+      }
+      for (auto& t : threads)
+      {
+        t.join();
+      }
+    }
+  }
+  catch (std::runtime_error& e)
+  {
+    printf("Sandbox exception: %s while making mixed calls\n", e.what());
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,84 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Latency benchmark for sandbox calls.
+ *
+ * Makes a number of synchronous calls to a function that does nothing but
+ * return its argument, so that the time for each is the cost of the round trip
+ * to the child, and reports the mean, median, and 99th percentile latencies.
+ * The first calls are not timed, so that the adaptive spinning in the parent
+ * and the child has settled.
+ */
+
+#include "process_sandbox/cxxsandbox.h"
+#include "process_sandbox/sandbox.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+using namespace sandbox;
+
+int identity(int);
+
+/**
+ * The structure that represents an instance of the sandbox.
+ */
+struct NullCallSandbox
+{
+  /**
+   * The library that defines the functions exposed by this sandbox.
+   */
+  Library lib = {SANDBOX_LIBRARY};
+#define EXPORTED_FUNCTION(public_name, private_name) \
+  decltype(make_sandboxed_function<decltype(private_name)>(lib)) public_name = \
+    make_sandboxed_function<decltype(private_name)>(lib);
+  EXPORTED_FUNCTION(identity, ::identity)
+};
+
+int main(int argc, char** argv)
+{
+  size_t calls = (argc > 1) ? strtoul(argv[1], nullptr, 0) : 100000;
+  const size_t warmup = 1000;
+  using Clock = std::chrono::steady_clock;
+
+  NullCallSandbox sandbox;
+  for (size_t i = 0; i < warmup; i++)
+  {
+    sandbox.identity(static_cast<int>(i));
+  }
+
+  std::vector<int64_t> latencies;
+  latencies.reserve(calls);
+  for (size_t i = 0; i < calls; i++)
+  {
+    auto start = Clock::now();
+    int ret = sandbox.identity(static_cast<int>(i));
+    auto end = Clock::now();
+    SANDBOX_INVARIANT(
+      ret == static_cast<int>(i), "identity({}) returned {}", i, ret);
+    latencies.push_back(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+        .count());
+  }
+  if (latencies.empty())
+  {
+    return 0;
+  }
+
+  int64_t total = 0;
+  for (auto l : latencies)
+  {
+    total += l;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  printf(
+    "%zu null calls: mean %lldns, median %lldns, 99th percentile %lldns\n",
+    calls,
+    static_cast<long long>(total / static_cast<int64_t>(calls)),
+    static_cast<long long>(latencies[calls / 2]),
+    static_cast<long long>(latencies[(calls * 99) / 100]));
+  return 0;
+}
@@ -0,0 +1,157 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Test and latency benchmark for sandbox pools.
+ *
+ * Checks that each sandbox handed out by a pool is fresh, and that a sandbox
+ * that crashes is replaced.  Then compares the time to start a sandbox and
+ * make a call to it (cold) with the time to take one from a pool and make a
+ * call to it (warm), and reports the mean and median of each along with the
+ * pool's statistics.
+ */
+
+#include "process_sandbox/cxxsandbox.h"
+#include "process_sandbox/sandbox.h"
+#include "process_sandbox/sandbox_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+using namespace sandbox;
+
+int increment();
+int crash();
+
+/**
+ * The structure that represents an instance of the sandbox.
+ */
+struct PoolSandbox
+{
+  /**
+   * The library that defines the functions exposed by this sandbox.
+   */
+  Library lib = {SANDBOX_LIBRARY};
+#define EXPORTED_FUNCTION(public_name, private_name) \
+  decltype(make_sandboxed_function<decltype(private_name)>(lib)) public_name = \
+    make_sandboxed_function<decltype(private_name)>(lib);
+  EXPORTED_FUNCTION(increment, ::increment)
+  EXPORTED_FUNCTION(crash, ::crash)
+};
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Print the mean and median of `latencies`, in microseconds.
+ */
+void report(const char* name, std::vector<int64_t>& latencies)
+{
+  int64_t total = 0;
+  for (auto l : latencies)
+  {
+    total += l;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  printf(
+    "%s: %zu acquisitions, mean %lldus, median %lldus\n",
+    name,
+    latencies.size(),
+    static_cast<long long>(total / static_cast<int64_t>(latencies.size())),
+    static_cast<long long>(latencies[latencies.size() / 2]));
+}
+
+/**
+ * Returns the time since `start` in microseconds.
+ */
+int64_t since(Clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+           Clock::now() - start)
+    .count();
+}
+
+int main(int argc, char** argv)
+{
+  size_t rounds = (argc > 1) ? strtoul(argv[1], nullptr, 0) : 20;
+  rounds = std::max<size_t>(rounds, 1);
+  const size_t pool_size = 2;
+
+  SandboxPool<PoolSandbox> pool(pool_size);
+  auto wait_until_full = [&]() {
+    while (pool.stats().ready < pool_size)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  };
+
+  // Every sandbox starts with the library's globals in their initial state.
+  for (int i = 0; i < 4; i++)
+  {
+    auto sandbox = pool.acquire();
+    int ret = sandbox->increment();
+    SANDBOX_INVARIANT(ret == 1, "Sandbox {} was reused, count is {}", i, ret);
+    ret = sandbox->increment();
+    SANDBOX_INVARIANT(ret == 2, "Second call returned {}, expected 2", ret);
+  }
+
+  // A sandbox that crashes is replaced.
+  {
+    auto sandbox = pool.acquire();
+    bool threw = false;
+    try
+    {
+      sandbox->crash();
+    }
+    catch (std::runtime_error&)
+    {
+      threw = true;
+    }
+    SANDBOX_INVARIANT(threw, "Crashing sandbox did not raise an exception");
+  }
+  SANDBOX_INVARIANT(
+    pool.stats().crashed == 1,
+    "Pool reported {} crashes, expected 1",
+    pool.stats().crashed);
+  SANDBOX_INVARIANT(
+    pool.acquire()->increment() == 1, "Sandbox after crash was not fresh");
+
+  std::vector<int64_t> cold;
+  for (size_t i = 0; i < rounds; i++)
+  {
+    auto start = Clock::now();
+    PoolSandbox sandbox;
+    sandbox.increment();
+    cold.push_back(since(start));
+  }
+
+  std::vector<int64_t> warm;
+  for (size_t i = 0; i < rounds; i++)
+  {
+    // Give the pool time to replace the last sandbox, so that this measures
+    // a pool that is keeping up with requests.
+    wait_until_full();
+    auto start = Clock::now();
+    auto sandbox = pool.acquire();
+    sandbox->increment();
+    warm.push_back(since(start));
+  }
+
+  report("cold", cold);
+  report("warm", warm);
+  auto stats = pool.stats();
+  printf(
+    "pool: %zu warm and %zu cold acquisitions, %zu started, %zu recycled, "
+    "%zu crashed, %zu failed to start, %zu ready, %zu in use\n",
+    stats.warm_acquires,
+    stats.cold_acquires,
+    stats.started,
+    stats.recycled,
+    stats.crashed,
+    stats.failed_starts,
+    stats.ready,
+    stats.in_use);
+  return 0;
+}
@@ -0,0 +1,213 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Throughput benchmark for asynchronous sandbox calls.
+ *
+ * Several threads each compress the same file with their own zlib stream in
+ * one sandbox, first with synchronous calls and then with asynchronous calls.
+ * Synchronous calls from different threads take turns, each with its own
+ * round trip to the child, whereas the child runs the asynchronous calls
+ * queued by all of the threads in a batch each time that it is woken.  Checks
+ * that every thread gets the same output as a single thread, and reports the
+ * throughput of each.
+ */
+
+#include "process_sandbox/cxxsandbox.h"
+#include "process_sandbox/sandbox.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+#include <zlib.h>
+
+using namespace sandbox;
+
+/**
+ * The structure that represents an instance of the sandbox.
+ */
+struct SandboxZlib
+{
+  /**
+   * The library that defines the functions exposed by this sandbox.
+   */
+  Library lib = {SANDBOX_LIBRARY};
+#define EXPORTED_FUNCTION(public_name, private_name) \
+  decltype(make_sandboxed_function<decltype(private_name)>(lib)) public_name = \
+    make_sandboxed_function<decltype(private_name)>(lib);
+#include "zlib.inc"
+};
+
+/**
+ * Make a synchronous call.
+ */
+auto sync_call = [](auto& fn, auto... args) { return fn(args...); };
+
+/**
+ * Make an asynchronous call and wait for it.  Each thread has a single call
+ * in flight, so it is the calls from different threads that are batched.
+ */
+auto async_call = [](auto& fn, auto... args) {
+  return fn.async(args...).get();
+};
+
+/**
+ * Compress `input` with a zlib stream in the sandbox, making each call with
+ * `call`, and append the output to `result`.  Returns the number of calls.
+ */
+template<typename Call>
+size_t compress(
+  SandboxZlib& sandbox,
+  const std::vector<char>& input,
+  std::vector<char>& result,
+  Call&& call)
+{
+  static const size_t buffer_size = 1024;
+  auto optional_in = sandbox.lib.alloc<char>(buffer_size);
+  auto optional_out = sandbox.lib.alloc<char>(buffer_size);
+  SANDBOX_INVARIANT(optional_in && optional_out, "Buffer allocation failed");
+  auto in = optional_in.value();
+  auto out = optional_out.value();
+  char* version = sandbox.lib.strdup(ZLIB_VERSION);
+  auto ozs = sandbox.lib.alloc<z_stream>();
+  SANDBOX_INVARIANT(ozs.has_value(), "Allocation failed");
+  z_stream* zs = ozs.value();
+  size_t calls = 0;
+
+  memset(zs, 0, sizeof(*zs));
+  zs->zalloc = Z_NULL;
+  zs->zfree = Z_NULL;
+  int ret = call(
+    sandbox.deflateInit_,
+    zs,
+    Z_DEFAULT_COMPRESSION,
+    static_cast<const char*>(version),
+    static_cast<int>(sizeof(z_stream)));
+  calls++;
+  SANDBOX_INVARIANT(
+    ret == Z_OK, "deflateInit returned {}, expected {}", ret, Z_OK);
+
+  auto take_output = [&]() {
+    size_t avail_out = std::min<size_t>(zs->avail_out, buffer_size);
+    result.insert(result.end(), out, out + (buffer_size - avail_out));
+    zs->next_out = reinterpret_cast<Bytef*>(out);
+    zs->avail_out = buffer_size;
+  };
+  zs->next_out = reinterpret_cast<Bytef*>(out);
+  zs->avail_out = buffer_size;
+
+  for (size_t offset = 0; offset < input.size(); offset += buffer_size)
+  {
+    size_t length = std::min(buffer_size, input.size() - offset);
+    memcpy(in, input.data() + offset, length);
+    zs->next_in = reinterpret_cast<Bytef*>(in);
+    zs->avail_in = length;
+    while (zs->avail_in > 0)
+    {
+      SANDBOX_INVARIANT(
+        call(sandbox.deflate, zs, Z_NO_FLUSH) != Z_STREAM_ERROR,
+        "deflate returned Z_STREAM_ERROR");
+      calls++;
+      take_output();
+    }
+  }
+  do
+  {
+    ret = call(sandbox.deflate, zs, Z_FINISH);
+    calls++;
+    take_output();
+  } while (ret == Z_OK);
+  SANDBOX_INVARIANT(
+    ret == Z_STREAM_END, "deflate returned {}, expected {}", ret, Z_STREAM_END);
+  call(sandbox.deflateEnd, zs);
+  calls++;
+
+  sandbox.lib.free(zs);
+  sandbox.lib.free(version);
+  sandbox.lib.free(in);
+  sandbox.lib.free(out);
+  return calls;
+}
+
+/**
+ * Compress `input` `rounds` times in each of `thread_count` threads, check
+ * that each gives `expected`, and report the throughput.
+ */
+template<typename Call>
+void run(
+  const char* name,
+  SandboxZlib& sandbox,
+  const std::vector<char>& input,
+  const std::vector<char>& expected,
+  size_t thread_count,
+  size_t rounds,
+  Call&& call)
+{
+  std::vector<std::thread> threads;
+  std::atomic<size_t> calls = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < thread_count; i++)
+  {
+    threads.emplace_back([&]() {
+      for (size_t r = 0; r < rounds; r++)
+      {
+        std::vector<char> result;
+        calls += compress(sandbox, input, result, call);
+        SANDBOX_INVARIANT(
+          result == expected,
+          "{} compression gave {} bytes, expected {}",
+          name,
+          result.size(),
+          expected.size());
+      }
+    });
+  }
+  for (auto& t : threads)
+  {
+    t.join();
+  }
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count();
+  printf(
+    "%s: %zu calls from %zu threads in %lldms (%.0f calls/s)\n",
+    name,
+    calls.load(),
+    thread_count,
+    static_cast<long long>(ms),
+    calls * 1000.0 / std::max<long long>(ms, 1));
+}
+
+int main(int argc, char** argv)
+{
+  size_t thread_count = (argc > 1) ? strtoul(argv[1], nullptr, 0) : 4;
+  size_t rounds = (argc > 2) ? strtoul(argv[2], nullptr, 0) : 4;
+
+  std::vector<char> input;
+  {
+    int fd = open(argv[0], O_RDONLY);
+    SANDBOX_INVARIANT(fd >= 0, "Failed to open {}", argv[0]);
+    char buffer[4096];
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+      input.insert(input.end(), buffer, buffer + length);
+    }
+    close(fd);
+  }
+
+  SandboxZlib sandbox;
+  try
+  {
+    std::vector<char> expected;
+    compress(sandbox, input, expected, sync_call);
+    run("sync", sandbox, input, expected, thread_count, rounds, sync_call);
+    run("async", sandbox, input, expected, thread_count, rounds, async_call);
+  }
+  catch (std::runtime_error& e)
+  {
+    printf("Sandbox exception: %s while running zlib compress\n", e.what());
+    return -1;
+  }
+  return 0;
+}
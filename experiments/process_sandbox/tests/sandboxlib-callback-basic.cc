@@ -12,7 +12,22 @@ int test(int idx)
   return ret;
 }
 
+int repeat(int idx, int count)
+{
+  int v = 12;
+  int successes = 0;
+  for (int i = 0; i < count; i++)
+  {
+    if (sandbox::invoke_user_callback(idx, &v, sizeof(v)) == 42)
+    {
+      successes++;
+    }
+  }
+  return successes;
+}
+
 extern "C" void sandbox_init()
 {
   sandbox::ExportedLibrary::export_function(::test);
+  sandbox::ExportedLibrary::export_function(::repeat);
 }
@@ -6,6 +6,7 @@
 #include "process_sandbox/platform/platform.h"
 #include "process_sandbox/sandbox.h"
 
+#include <fcntl.h>
 #include <signal.h>
 #include <sys/syscall.h>
 #include <unistd.h>
@@ -40,7 +41,47 @@ int test(bool raw_syscall)
   return bytes;
 }
 
+/**
+ * Check that `/foo` is readable `count` times.  `access` is emulated with a
+ * callback that does not pass a file descriptor.  Returns the number of
+ * checks that succeeded.
+ */
+int access_loop(int count)
+{
+  int successes = 0;
+  for (int i = 0; i < count; i++)
+  {
+    if (access("/foo", R_OK) == 0)
+    {
+      successes++;
+    }
+  }
+  return successes;
+}
+
+/**
+ * Open and close `/foo` `count` times.  `open` is emulated with a callback
+ * that returns a file descriptor.  Returns the number of opens that
+ * succeeded.
+ */
+int open_loop(int count)
+{
+  int successes = 0;
+  for (int i = 0; i < count; i++)
+  {
+    int fd = open("/foo", O_RDONLY);
+    if (fd >= 0)
+    {
+      close(fd);
+      successes++;
+    }
+  }
+  return successes;
+}
+
 extern "C" void sandbox_init()
 {
   sandbox::ExportedLibrary::export_function(::test);
+  sandbox::ExportedLibrary::export_function(::access_loop);
+  sandbox::ExportedLibrary::export_function(::open_loop);
 }
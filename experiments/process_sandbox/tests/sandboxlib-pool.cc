@@ -0,0 +1,27 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+#include "process_sandbox/cxxsandbox.h"
+#include "process_sandbox/sandbox.h"
+
+#include <stdlib.h>
+
+/**
+ * Count the calls to this function in this sandbox.
+ */
+int increment()
+{
+  static int counter = 0;
+  return ++counter;
+}
+
+int crash()
+{
+  abort();
+}
+
+extern "C" void sandbox_init()
+{
+  sandbox::ExportedLibrary::export_function(::increment);
+  sandbox::ExportedLibrary::export_function(::crash);
+}
@@ -0,0 +1,232 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#if !defined(__cpp_impl_coroutine)
+#  error "Coroutine behaviours require C++20"
+#endif
+
+#include "when.h"
+
+#include <coroutine>
+#include <optional>
+#include <tuple>
+#include <variant>
+
+namespace verona::cpp
+{
+  using namespace verona::rt;
+
+  /**
+   * The return type of a coroutine behaviour.
+   *
+   * A coroutine behaviour is a C++20 coroutine that can suspend, without
+   * blocking its thread, until a `when` or a `Promise` is ready:
+   *
+   *   async_behaviour transfer(cown_ptr<Account> from, cown_ptr<Account> to)
+   *   {
+   *     auto [f, t] = co_await when(from, to);
+   *     f->balance -= 10;
+   *     t->balance += 10;
+   *   }
+   *
+   * `co_await when(...)` schedules a behaviour on the cowns, which resumes the
+   * coroutine once they have been acquired, and returns the acquired cowns, a
+   * single `acquired_cown` or an `acquired_cowns`.  The coroutine then runs as
+   * the body of that behaviour, until it next suspends or returns, and the
+   * cowns are released.  So, as in a `when`, the acquired cowns must not be
+   * used after the next `co_await`.  `co_await when()` suspends the coroutine
+   * until it is resumed by a scheduler thread.
+   *
+   * `co_await` on a `Promise`'s read end point resumes the coroutine with its
+   * value, or the error if it is never fulfilled, see `Promise::then`.
+   *
+   * The coroutine starts when it is called, and runs on the caller's thread
+   * until it first suspends.  Its frame, which holds its state across
+   * suspensions, is allocated from the runtime's allocator, and freed when it
+   * returns.  The caller does not wait for it.
+   *
+   * A coroutine behaviour must not suspend in any other way, as nothing
+   * would resume it.
+   */
+  class async_behaviour
+  {
+  public:
+    struct promise_type
+    {
+      async_behaviour get_return_object()
+      {
+        return {};
+      }
+
+      std::suspend_never initial_suspend() noexcept
+      {
+        return {};
+      }
+
+      std::suspend_never final_suspend() noexcept
+      {
+        return {};
+      }
+
+      void return_void() {}
+
+      void unhandled_exception()
+      {
+        abort();
+      }
+
+      static void* operator new(size_t size)
+      {
+        return ThreadAlloc::get().alloc(size);
+      }
+
+      static void operator delete(void* p, size_t size)
+      {
+        ThreadAlloc::get().dealloc(p, size);
+      }
+    };
+  };
+
+  /**
+   * The cowns acquired by `co_await when(...)` on more than one cown.
+   *
+   * Use a structured binding to get an `acquired_cown` for each of them:
+   *
+   *   auto [a, b] = co_await when(x, y);
+   *
+   * As with an `acquired_cown`, this must not be used after the coroutine
+   * next suspends.
+   */
+  template<typename... Args>
+  class acquired_cowns
+  {
+    template<typename... Args2>
+    friend class WhenAwaiter;
+
+    std::tuple<Access<Args>...> cown_tuple;
+
+    acquired_cowns(const std::tuple<Access<Args>...>& cown_tuple)
+    : cown_tuple(cown_tuple)
+    {}
+
+  public:
+    template<size_t index>
+    auto get() const
+    {
+      using T = std::tuple_element_t<index, std::tuple<Args...>>;
+      return acquired_cown<T>(*std::get<index>(cown_tuple).t);
+    }
+  };
+
+  /**
+   * Suspends a coroutine behaviour until a `when` has acquired its cowns,
+   * see `async_behaviour`.
+   */
+  template<typename... Args>
+  class WhenAwaiter
+  {
+    When<Args...> w;
+
+  public:
+    WhenAwaiter(When<Args...> w) : w(w) {}
+
+    bool await_ready()
+    {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      // The coroutine may be resumed on another thread as soon as the
+      // behaviour is scheduled, so this must not touch the frame afterwards.
+      if constexpr (sizeof...(Args) == 0)
+      {
+        schedule_lambda([h]() { h.resume(); });
+      }
+      else
+      {
+        Request requests[sizeof...(Args)];
+        w.array_assign(requests);
+        schedule_lambda(sizeof...(Args), requests, [h]() { h.resume(); });
+      }
+    }
+
+    auto await_resume()
+    {
+      if constexpr (sizeof...(Args) == 1)
+        return acquired_cowns<Args...>(w.cown_tuple).template get<0>();
+      else if constexpr (sizeof...(Args) > 1)
+        return acquired_cowns<Args...>(w.cown_tuple);
+    }
+  };
+
+  template<typename... Args>
+  WhenAwaiter<Args...> operator co_await(When<Args...> w)
+  {
+    return WhenAwaiter<Args...>(w);
+  }
+} // namespace verona::cpp
+
+namespace verona::rt
+{
+  /**
+   * Suspends a coroutine behaviour until a promise is fulfilled, see
+   * `verona::cpp::async_behaviour`.
+   */
+  template<typename T>
+  class PromiseAwaiter
+  {
+    using Result = std::variant<T, typename Promise<T>::PromiseErr>;
+
+    typename Promise<T>::PromiseR promise;
+    std::optional<Result> result;
+
+  public:
+    PromiseAwaiter(typename Promise<T>::PromiseR&& promise)
+    : promise(std::move(promise))
+    {}
+
+    bool await_ready()
+    {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      promise.then([this, h](Result value) {
+        result.emplace(std::move(value));
+        h.resume();
+      });
+    }
+
+    Result await_resume()
+    {
+      return std::move(*result);
+    }
+  };
+
+  template<typename R>
+  requires std::is_same_v<
+    std::remove_cvref_t<R>,
+    typename Promise<typename std::remove_cvref_t<R>::value_type>::PromiseR>
+    PromiseAwaiter<typename std::remove_cvref_t<R>::value_type>
+    operator co_await(R&& promise)
+  {
+    using T = typename std::remove_cvref_t<R>::value_type;
+    typename Promise<T>::PromiseR r = std::forward<R>(promise);
+    return PromiseAwaiter<T>(std::move(r));
+  }
+} // namespace verona::rt
+
+template<typename... Args>
+struct std::tuple_size<verona::cpp::acquired_cowns<Args...>>
+: std::integral_constant<size_t, sizeof...(Args)>
+{};
+
+template<size_t index, typename... Args>
+struct std::tuple_element<index, verona::cpp::acquired_cowns<Args...>>
+{
+  using type = verona::cpp::acquired_cown<
+    std::tuple_element_t<index, std::tuple<Args...>>>;
+};
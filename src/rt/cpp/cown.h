@@ -174,6 +174,9 @@ namespace verona::cpp
     template<typename TT, typename... Args>
     friend cown_ptr<TT> make_cown(Args&&...);
 
+    template<typename TT, typename... Args>
+    friend cown_ptr<TT> make_read_mostly_cown(Args&&...);
+
     template<typename...>
     friend class When;
   };
@@ -214,6 +217,18 @@ namespace verona::cpp
     return cown_ptr<T>(new ActualCown<T>(std::forward<Args>(ts)...));
   }
 
+  /**
+   * Used to construct a new cown_ptr for a cown that is read far more often
+   * than it is written, see `Cown::mark_read_mostly`.
+   */
+  template<typename T, typename... Args>
+  cown_ptr<T> make_read_mostly_cown(Args&&... ts)
+  {
+    auto cown = make_cown<T>(std::forward<Args>(ts)...);
+    cown.underlying_cown()->mark_read_mostly();
+    return cown;
+  }
+
   /**
    * Represents a cown that has been acquired in a `when` clause.
    *
@@ -231,6 +246,10 @@ namespace verona::cpp
     template<typename...>
     friend class When;
 
+    /// Needed to build one when a coroutine is resumed, see `coroutine.h`.
+    template<typename...>
+    friend class acquired_cowns;
+
   private:
     /// Underlying cown that has been acquired.
     /// Runtime is actually holding this reference count.
@@ -0,0 +1,308 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "../sched/messagepool.h"
+#include "lambdabehaviour.h"
+
+#include <atomic>
+#include <optional>
+#include <variant>
+
+namespace verona::rt
+{
+  /**
+   * A promise for a single request and response, that is cheaper than a
+   * `Promise`.
+   *
+   * A `Promise` is a cown, so each `then` schedules a behaviour on it, and
+   * fulfilling it schedules the cown to run them.  An `InlinePromise` instead
+   * stores the value inline, and has a single continuation, which is run
+   * directly, on the thread that fulfils the promise, or on the thread that
+   * calls `then` if the promise was already fulfilled.  The promise is
+   * allocated from the runtime's message pools, see `MessagePool`, so a round
+   * trip on a scheduler thread does not call into the allocator.
+   *
+   * A continuation that needs access to a cown is passed with that cown to
+   * `then`, and is run as a behaviour on the cown once the promise is
+   * fulfilled.  This is the only case that schedules a behaviour.
+   *
+   * As a continuation may run on the fulfilling thread, within whatever
+   * behaviour that thread is running, it must be short, and must only access
+   * state it owns.
+   *
+   * There is a single writer, the `PromiseW` end point, which can fulfil the
+   * promise once, and a single reader, the `PromiseR` end point, which can
+   * add the continuation once.  If the writer is dropped without fulfilling
+   * the promise, the continuation is passed a `PromiseErr`.
+   */
+  template<typename T>
+  class InlinePromise
+  {
+  public:
+    class PromiseErr
+    {
+      friend class InlinePromise;
+
+      int err_code;
+      PromiseErr(int code) : err_code(code) {}
+    };
+
+    using Result = std::variant<T, PromiseErr>;
+
+  private:
+    /**
+     * Continuation closures up to this size are stored inline, and larger
+     * ones are allocated separately.
+     */
+    static constexpr size_t CLOSURE_SIZE = 6 * sizeof(void*);
+
+    enum class State : uint8_t
+    {
+      // Neither the continuation nor the result has been set.
+      Empty,
+      // The continuation is waiting for the result.
+      Waiting,
+      // The result has been set, and the continuation run if it was waiting.
+      Done,
+    };
+
+    std::atomic<State> state{State::Empty};
+
+    // One for each end point.
+    std::atomic<size_t> ref_count{2};
+
+    std::optional<Result> result;
+
+    // Runs the continuation with the result, and destroys it.
+    void (*run)(void* closure, Result&& result) = nullptr;
+    alignas(void*) std::byte closure[CLOSURE_SIZE];
+
+    InlinePromise() = default;
+
+    void release()
+    {
+      if (ref_count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+      this->~InlinePromise();
+      MessagePool::dealloc_body(ThreadAlloc::get(), this, sizeof(*this));
+    }
+
+    template<typename F>
+    void set_continuation(F&& fn)
+    {
+      using Fn = std::decay_t<F>;
+
+      assert(run == nullptr);
+      if constexpr (
+        (sizeof(Fn) <= CLOSURE_SIZE) && (alignof(Fn) <= alignof(void*)))
+      {
+        new (closure) Fn(std::forward<F>(fn));
+        run = [](void* c, Result&& r) {
+          auto* f = static_cast<Fn*>(c);
+          (*f)(std::move(r));
+          f->~Fn();
+        };
+      }
+      else
+      {
+        auto* f = new (ThreadAlloc::get().alloc(sizeof(Fn)))
+          Fn(std::forward<F>(fn));
+        *reinterpret_cast<Fn**>(closure) = f;
+        run = [](void* c, Result&& r) {
+          auto* f = *static_cast<Fn**>(c);
+          (*f)(std::move(r));
+          f->~Fn();
+          ThreadAlloc::get().dealloc(f, sizeof(Fn));
+        };
+      }
+    }
+
+    /**
+     * Called by the reader once the continuation is set.  If the promise is
+     * not yet fulfilled, the reader's reference passes to the writer, which
+     * releases it after running the continuation.
+     */
+    void wait()
+    {
+      auto expected = State::Empty;
+      if (state.compare_exchange_strong(
+            expected, State::Waiting, std::memory_order_acq_rel))
+        return;
+
+      // Already fulfilled, so run the continuation now.
+      assert(expected == State::Done);
+      run(closure, std::move(*result));
+      release();
+    }
+
+    /**
+     * Called by the writer once the result is set.
+     */
+    void complete()
+    {
+      auto prev = state.exchange(State::Done, std::memory_order_acq_rel);
+      assert(prev != State::Done);
+
+      if (prev == State::Waiting)
+      {
+        run(closure, std::move(*result));
+        release();
+      }
+    }
+
+  public:
+    /**
+     * The read end point of the promise.
+     */
+    class PromiseR
+    {
+      friend class InlinePromise;
+
+      InlinePromise* promise = nullptr;
+
+      PromiseR(InlinePromise* p) : promise(p) {}
+
+    public:
+      PromiseR() = default;
+
+      PromiseR(PromiseR&& old) : promise(old.promise)
+      {
+        old.promise = nullptr;
+      }
+
+      PromiseR& operator=(PromiseR&& old)
+      {
+        if (promise != nullptr)
+          promise->release();
+        promise = old.promise;
+        old.promise = nullptr;
+        return *this;
+      }
+
+      PromiseR(const PromiseR&) = delete;
+      PromiseR& operator=(const PromiseR&) = delete;
+
+      ~PromiseR()
+      {
+        if (promise != nullptr)
+          promise->release();
+      }
+
+      /**
+       * Run `fn` with the result, when the promise is fulfilled or its writer
+       * is dropped.  This consumes the read end point.
+       */
+      template<
+        typename F,
+        typename = std::enable_if_t<std::is_invocable_v<F, Result>>>
+      void then(F&& fn)
+      {
+        assert(promise != nullptr);
+        auto* p = promise;
+        promise = nullptr;
+
+        p->set_continuation(std::forward<F>(fn));
+        p->wait();
+      }
+
+      /**
+       * Run `fn` with the result in a behaviour on `cown`, when the promise
+       * is fulfilled or its writer is dropped.  This consumes the read end
+       * point.
+       */
+      template<
+        typename F,
+        typename = std::enable_if_t<std::is_invocable_v<F, Result>>>
+      void then(Cown* cown, F&& fn)
+      {
+        Cown::acquire(cown);
+        then([cown, fn = std::forward<F>(fn)](Result&& r) mutable {
+          schedule_lambda<YesTransfer>(
+            cown, [fn = std::move(fn), r = std::move(r)]() mutable {
+              fn(std::move(r));
+            });
+        });
+      }
+    };
+
+    /**
+     * The write end point of the promise.
+     */
+    class PromiseW
+    {
+      friend class InlinePromise;
+
+      InlinePromise* promise = nullptr;
+
+      PromiseW(InlinePromise* p) : promise(p) {}
+
+    public:
+      PromiseW() = default;
+
+      PromiseW(PromiseW&& old) : promise(old.promise)
+      {
+        old.promise = nullptr;
+      }
+
+      PromiseW& operator=(PromiseW&& old)
+      {
+        reset();
+        promise = old.promise;
+        old.promise = nullptr;
+        return *this;
+      }
+
+      PromiseW(const PromiseW&) = delete;
+      PromiseW& operator=(const PromiseW&) = delete;
+
+      ~PromiseW()
+      {
+        reset();
+      }
+
+    private:
+      /**
+       * Drop this end point, which fails the promise if it has not been
+       * fulfilled.
+       */
+      void reset()
+      {
+        if (promise == nullptr)
+          return;
+
+        auto* p = promise;
+        promise = nullptr;
+        p->result.emplace(PromiseErr(-1));
+        p->complete();
+        p->release();
+      }
+    };
+
+    /**
+     * Create a promise and get its read and write end points.
+     */
+    static std::pair<PromiseR, PromiseW> create_promise()
+    {
+      auto* p = new (MessagePool::alloc_body(
+        ThreadAlloc::get(), sizeof(InlinePromise))) InlinePromise;
+      return std::make_pair(PromiseR(p), PromiseW(p));
+    }
+
+    /**
+     * Fulfil the promise with a value, and run its continuation if it is
+     * waiting.  A PromiseW can be fulfilled only once.
+     */
+    static void fulfill(PromiseW&& wp, T&& v)
+    {
+      assert(wp.promise != nullptr);
+      auto* p = wp.promise;
+      wp.promise = nullptr;
+
+      p->result.emplace(std::move(v));
+      p->complete();
+      p->release();
+    }
+  };
+} // namespace verona::rt
@@ -48,6 +48,8 @@ namespace verona::rt
       PromiseR& operator=(const PromiseR&) = delete;
 
     public:
+      using value_type = T;
+
       template<
         typename F,
         typename =
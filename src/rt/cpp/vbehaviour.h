@@ -62,6 +62,14 @@ namespace verona::rt
         "Template parameter must inherit from Behaviour.");
     }
 
+    /**
+     * Identifies this type of behaviour, for example in `BehaviourLatency`.
+     */
+    static const Behaviour::Descriptor* type_descriptor()
+    {
+      return desc();
+    }
+
   private:
     /**
      * Placement new for allocating in already allocated memory
@@ -27,6 +27,9 @@ namespace verona::cpp
 
     template<typename... Args>
     friend class When;
+
+    template<typename... Args>
+    friend class acquired_cowns;
   };
 
   /**
@@ -56,6 +59,10 @@ namespace verona::cpp
     template<typename... Args2>
     friend auto when(Args2&&... args);
 
+    // Schedules the behaviour that resumes a coroutine, see `coroutine.h`.
+    template<typename... Args2>
+    friend class WhenAwaiter;
+
     /**
      * Internally uses AcquiredCown.  The cown is only acquired after the
      * behaviour is scheduled.
@@ -4,6 +4,7 @@
 
 #include <atomic>
 #include <snmalloc/snmalloc.h>
+#include <thread>
 
 namespace verona::rt
 {
@@ -45,6 +46,25 @@ namespace verona::rt
    *      queue receives multiple calls to "notify" it may consolidate them into
    *      a single call. This supports zero allocation notifications in the
    *      runtime.
+   *
+   * Elements can also be enqueued "locked", which holds back every later
+   * locked enqueue on the same queue until the element is unlocked.  A later
+   * producer still takes its place at the `back` and links itself in, but a
+   * locked enqueue does not return, and the consumer does not move past the
+   * locked element, until every locked element before it has been unlocked.
+   * Producers that do not lock never wait.
+   *
+   * This is used to give multi-messages a consistent order on all of the
+   * queues they are sent to, without a separate lock per queue: the messages
+   * are enqueued locked in a global order, and unlocked together once the
+   * last one has been enqueued.
+   *
+   * Locking is recorded in the low bits of the element's `next` field, so it
+   * takes no extra space, along with whether every locked element before it
+   * has been unlocked, "ready".  Whoever makes an element both ready and
+   * unlocked passes readiness on to the element linked after it, so it
+   * reaches a locked producer without the producers that did not lock waiting
+   * for each other.
    **/
 
   template<class T>
@@ -64,8 +84,23 @@ namespace verona::rt
       STATES = 0x3,
     };
 
+    // SLEEPING is only ever set on `back`, so the same bit marks a locked
+    // element in its own `next` field.  NOTIFY is passed on with the link to
+    // the next element, and READY marks an element that every locked element
+    // before it has been unlocked, see `ready`.
+    static constexpr STATE LOCKED = SLEEPING;
+    static constexpr uintptr_t READY = 0x4;
+    static constexpr uintptr_t NEXT_STATES = STATES | READY;
+
     static constexpr uintptr_t MASK = ~static_cast<uintptr_t>(STATES);
+    static constexpr uintptr_t NEXT_MASK = ~NEXT_STATES;
 
+    // Spins waiting for a locked message before yielding the processor.
+    static constexpr size_t SPIN_LIMIT = 128;
+
+    // `back` is written by producers and `front` only by the consumer.  They
+    // are kept in this order, so that an owner can put them on different
+    // cache lines, see `Cown`.
     std::atomic<T*> back;
     T* front;
 
@@ -95,6 +130,149 @@ namespace verona::rt
       return (T*)((uintptr_t)p & MASK);
     }
 
+    /**
+     * The element that `next` links to, or nullptr.
+     **/
+    inline static T* next_link(T* next)
+    {
+      return (T*)((uintptr_t)next & NEXT_MASK);
+    }
+
+    /**
+     * Returns true if the element whose `next` field this is has been made
+     * ready, see `ready`.
+     **/
+    inline static bool is_ready(T* next)
+    {
+      return ((uintptr_t)next & READY) != 0;
+    }
+
+    /**
+     * Returns true if the element whose `next` field this is has been made
+     * ready and is not locked, so the consumer may move past it.
+     **/
+    inline static bool is_passable(T* next)
+    {
+      return ((uintptr_t)next & (READY | LOCKED)) == READY;
+    }
+
+    /**
+     * Returns true if `next` links to another element, that the consumer may
+     * move on to, rather than being the end of the queue.
+     **/
+    inline static bool is_link(T* next)
+    {
+      return (next_link(next) != nullptr) && is_passable(next);
+    }
+
+    /**
+     * Sets the bits `add` and clears the bits `remove` in the `next` field of
+     * `t`, and returns its previous value.
+     **/
+    inline static T* update_next(T* t, uintptr_t add, uintptr_t remove = 0)
+    {
+      T* next = t->next.load(std::memory_order_relaxed);
+      while (!t->next.compare_exchange_weak(
+        next,
+        (T*)(((uintptr_t)next | add) & ~remove),
+        std::memory_order_acq_rel))
+      {
+      }
+      return next;
+    }
+
+    /**
+     * Marks `t` ready: every locked element before it has been unlocked.  If
+     * `t` is not locked, the same then holds for the element linked after it,
+     * if any, and so on.  Each element is made ready exactly once, by whoever
+     * finds its predecessor ready and unlocked with it linked: the producer
+     * that links it, or whoever makes the predecessor ready or unlocks it.
+     *
+     * The consumer does not move past an element until it is ready, so an
+     * element is not deallocated until after it has been made ready.
+     **/
+    inline static void ready(T* t)
+    {
+      while (t != nullptr)
+      {
+        T* next = update_next(t, READY);
+        assert(!is_ready(next));
+        if (((uintptr_t)next & LOCKED) != 0)
+          return;
+        t = next_link(next);
+      }
+    }
+
+    /**
+     * Enqueues the elements from `first` to `t`, which must already be linked
+     * through their `next` fields, with a single exchange on `back`.
+     **/
+    template<bool locked>
+    bool enqueue_inner(T* first, T* t)
+    {
+      assert(is_clear(first));
+      assert(is_clear(t));
+      // The low bits of `next` must be free for its states.
+      assert(next_link(t) == t);
+
+      invariant();
+      t->next.store(locked ? (T*)LOCKED : nullptr, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      T* prev = back.exchange(t, std::memory_order_relaxed);
+      bool was_sleeping;
+
+      yield();
+
+      // Pass on the notify info if set
+      T* link = first;
+      if (has_state(prev, NOTIFY))
+      {
+        link = set_state(first, NOTIFY);
+      }
+
+      was_sleeping = has_state(prev, SLEEPING);
+      prev = clear_state(prev);
+
+      // Nothing is deallocated while it is not linked to the next element, so
+      // `prev` stays valid until we link to it.  If `prev` is already ready
+      // and unlocked, which it stays, make our elements ready before they can
+      // be reached.
+      bool readied = is_passable(prev->next.load(std::memory_order_acquire));
+      if (readied)
+        ready(first);
+
+      yield();
+
+      // Release, so that the consumer observes our elements.  If `prev` was
+      // made ready and unlocked after we looked, it did not see our link, so
+      // we pass readiness on ourselves.
+      T* prev_next = update_next(prev, (uintptr_t)link);
+      assert(next_link(prev_next) == nullptr);
+      if (!readied && is_passable(prev_next))
+        ready(first);
+
+      // Once a locked element is ready, every earlier locked element on this
+      // queue has been unlocked.  The consumer does not move past `t` while it
+      // is locked, so it is not deallocated while we wait.  After a short
+      // spin, give up the processor, so that the producers we wait for can
+      // run even if the threads outnumber the cores.
+      if constexpr (locked)
+      {
+        for (size_t spins = 0;
+             !is_ready(t->next.load(std::memory_order_acquire));
+             spins++)
+        {
+          yield();
+          if (spins < SPIN_LIMIT)
+            snmalloc::Aal::pause();
+          else
+            std::this_thread::yield();
+        }
+      }
+
+      return was_sleeping;
+    }
+
   public:
     void invariant()
     {
@@ -106,7 +284,7 @@ namespace verona::rt
 
     void init(T* stub)
     {
-      stub->next.store(nullptr, std::memory_order_relaxed);
+      stub->next.store((T*)READY, std::memory_order_relaxed);
       front = stub;
 
       stub = set_state(stub, SLEEPING);
@@ -118,6 +296,8 @@ namespace verona::rt
     T* destroy()
     {
       T* fnt = front;
+      assert(next_link(fnt->next.load(std::memory_order_relaxed)) == nullptr);
+      fnt->next.store(nullptr, std::memory_order_relaxed);
       back.store(nullptr, std::memory_order_relaxed);
       front = nullptr;
       return fnt;
@@ -142,27 +322,50 @@ namespace verona::rt
      **/
     bool enqueue(T* t)
     {
-      assert(is_clear(t));
-
-      invariant();
-      t->next.store(nullptr, std::memory_order_relaxed);
-      std::atomic_thread_fence(std::memory_order_release);
-      T* prev = back.exchange(t, std::memory_order_relaxed);
-      bool was_sleeping;
-
-      yield();
+      return enqueue_inner<false>(t, t);
+    }
 
-      // Pass on the notify info if set
-      if (has_state(prev, NOTIFY))
-      {
-        t = set_state(t, NOTIFY);
-      }
+    /**
+     * Enqueues (inserts) the elements from `first` to `last`, which the caller
+     * has already linked through their `next` fields, as with `enqueue`.  The
+     * elements take consecutive places in the queue, and are enqueued with a
+     * single exchange on `back`, so they cost the producer no more than a
+     * single element.
+     *
+     * Returns true if the queue was sleeping when the elements were added.
+     **/
+    bool enqueue_chain(T* first, T* last)
+    {
+      return enqueue_inner<false>(first, last);
+    }
 
-      was_sleeping = has_state(prev, SLEEPING);
-      prev = clear_state(prev);
+    /**
+     * Enqueues (inserts) a message into the queue, and leaves it locked until
+     * `unlock` is called on it.
+     *
+     * Waits for every earlier locked message in this queue to be unlocked
+     * before returning, so that the caller observes every earlier locked
+     * chain released before it enqueues anywhere else.
+     *
+     * Returns true if the queue was sleeping when the message was added.
+     **/
+    bool enqueue_locked(T* t)
+    {
+      return enqueue_inner<true>(t, t);
+    }
 
-      prev->next.store(t, std::memory_order_relaxed);
-      return was_sleeping;
+    /**
+     * Unlocks `t`, which was enqueued by `enqueue_locked`.
+     *
+     * The message may be dequeued and deallocated as soon as it is unlocked,
+     * so it must not be accessed afterwards.
+     **/
+    static void unlock(T* t)
+    {
+      T* next = update_next(t, 0, LOCKED);
+      assert(((uintptr_t)next & LOCKED) != 0);
+      if (is_ready(next))
+        ready(next_link(next));
     }
 
     /**
@@ -184,26 +387,25 @@ namespace verona::rt
       assert(is_clear(fnt));
       T* next = fnt->next.load(std::memory_order_relaxed);
 
-      if (next == nullptr)
+      if (!is_link(next))
       {
         return nullptr;
       }
 
-      front = clear_state(next);
+      front = next_link(next);
 
       assert(front);
       std::atomic_thread_fence(std::memory_order_acquire);
 
-      alloc.dealloc(fnt, fnt->size());
+      fnt->dealloc(alloc);
       invariant();
 
-      if (has_state(next, NOTIFY))
+      if (((uintptr_t)next & NOTIFY) != 0)
       {
-        next = clear_state(next);
         notify = true;
       }
 
-      return next;
+      return front;
     }
 
     /**
@@ -228,7 +430,8 @@ namespace verona::rt
      **/
     T* peek()
     {
-      return clear_state(front->next.load(std::memory_order_relaxed));
+      T* next = front->next.load(std::memory_order_relaxed);
+      return is_link(next) ? next_link(next) : nullptr;
     }
 
     /**
@@ -227,6 +227,11 @@ namespace verona::rt
     // ensure that pointers to objects are aligned.
     static constexpr size_t ALIGNMENT = (1 << MIN_ALLOC_BITS);
 
+    // The alignment of the allocation, including the header, that a subclass
+    // needs.  A subclass can raise this to lay its fields out on cache lines,
+    // see `vsizeof`.
+    static constexpr size_t ALLOCATION_ALIGNMENT = ALIGNMENT;
+
     /// This class represents the Verona object header.
     /// It is stored directly before a Verona object.
     /// Its overall size is two pointers.
@@ -955,8 +960,12 @@ namespace verona::rt
 
   /// Returns the size required for a Verona object to embed the
   /// C++ object T.
+  ///
+  /// The size is a multiple of `T::ALLOCATION_ALIGNMENT`.  snmalloc aligns
+  /// each allocation to the largest power of two dividing its size class, so
+  /// this also aligns the allocation.
   template<class T>
   static constexpr size_t vsizeof = snmalloc::bits::align_up(
-    sizeof(T) + sizeof(Object::Header), Object::ALIGNMENT);
+    sizeof(T) + sizeof(Object::Header), T::ALLOCATION_ALIGNMENT);
 
 } // namespace verona::rt
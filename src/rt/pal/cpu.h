@@ -5,6 +5,7 @@
 #include <snmalloc/snmalloc.h>
 
 #if defined(__linux__)
+#  include <dirent.h>
 #  include <sched.h>
 #  include <stdio.h>
 #  include <stdlib.h>
@@ -42,6 +43,8 @@ namespace verona::rt
     {
       size_t numa_node;
       size_t package;
+      // Identifies the CPUs that share a last level cache.
+      size_t complex;
       size_t group;
       size_t id;
       bool hyperthread;
@@ -75,6 +78,13 @@ namespace verona::rt
         if (package > that.package)
           return false;
 
+        // Sort by core complex within a package.
+        if (complex < that.complex)
+          return true;
+
+        if (complex > that.complex)
+          return false;
+
         // Sort by group.
         if (group < that.group)
           return true;
@@ -100,12 +110,15 @@ namespace verona::rt
       uint32_t index = 0;
       uint32_t found = 0;
 
-      // TODO: CPU topology detection for Linux
       while (found < count)
       {
         if (CPU_ISSET(index, &all_cpus))
         {
-          cpus.push_back(CPU{0, 0, 0, index, false});
+#  if defined(__linux__)
+          cpus.push_back(get_linux_cpu(index));
+#  else
+          cpus.push_back(CPU{0, 0, 0, 0, index, false});
+#  endif
           found++;
         }
 
@@ -149,9 +162,11 @@ namespace verona::rt
 
             if (idmask & p->Processor.GroupMask[j].Mask)
             {
+              auto package_id = get_package(group, id, package, package_count);
               top->cpus.push_back(
                 CPU{get_numa_node(group, id, numa, numa_count),
-                    get_package(group, id, package, package_count),
+                    package_id,
+                    package_id,
                     group,
                     id,
                     hyperthread});
@@ -193,7 +208,7 @@ namespace verona::rt
         top->cpus.reserve(core_count);
         for (uint32_t index = 0; index < core_count; index++)
         {
-          top->cpus.push_back(CPU{0, 0, 0, index, false});
+          top->cpus.push_back(CPU{0, 0, 0, 0, index, false});
         }
       }
 #else
@@ -220,7 +235,102 @@ namespace verona::rt
       return cpus.size();
     }
 
+    /**
+     * Returns the NUMA node of the CPU returned by `get(index)`.
+     */
+    size_t get_numa_node(size_t index)
+    {
+      if (cpus.size() == 0)
+        abort();
+
+      return cpus.at(index % cpus.size()).numa_node;
+    }
+
+    /**
+     * Returns an identifier for the core complex of the CPU returned by
+     * `get(index)`, which is unique across packages.
+     */
+    size_t get_complex(size_t index)
+    {
+      if (cpus.size() == 0)
+        abort();
+
+      return cpus.at(index % cpus.size()).complex;
+    }
+
   private:
+#if defined(__linux__)
+    /**
+     * Reads the first number in a sysfs file, such as the first CPU in a CPU
+     * list.  Returns `otherwise` if there is no such file.
+     */
+    static size_t read_sysfs(const char* path, size_t otherwise)
+    {
+      FILE* f = fopen(path, "r");
+      if (f == nullptr)
+        return otherwise;
+
+      unsigned long value;
+      if (fscanf(f, "%lu", &value) != 1)
+        value = otherwise;
+
+      fclose(f);
+      return value;
+    }
+
+    static CPU get_linux_cpu(uint32_t id)
+    {
+      char path[128];
+      size_t numa_node = 0;
+
+      // The CPU's directory links to its NUMA node, as `node<n>`.
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", id);
+      DIR* dir = opendir(path);
+      if (dir != nullptr)
+      {
+        while (auto* entry = readdir(dir))
+        {
+          unsigned long node;
+          if (sscanf(entry->d_name, "node%lu", &node) == 1)
+          {
+            numa_node = node;
+            break;
+          }
+        }
+        closedir(dir);
+      }
+
+      snprintf(
+        path,
+        sizeof(path),
+        "/sys/devices/system/cpu/cpu%u/topology/physical_package_id",
+        id);
+      size_t package = read_sysfs(path, 0);
+
+      // Use the first CPU sharing the last level cache to identify the core
+      // complex, or the package if that is not known.
+      snprintf(
+        path,
+        sizeof(path),
+        "/sys/devices/system/cpu/cpu%u/cache/index3/shared_cpu_list",
+        id);
+      size_t complex = read_sysfs(path, (size_t)-1);
+      if (complex == (size_t)-1)
+        complex = package;
+
+      // All but the first hardware thread of a physical core are treated as
+      // hyperthreads.
+      snprintf(
+        path,
+        sizeof(path),
+        "/sys/devices/system/cpu/cpu%u/topology/thread_siblings_list",
+        id);
+      bool hyperthread = read_sysfs(path, id) != id;
+
+      return CPU{numa_node, package, complex, 0, id, hyperthread};
+    }
+#endif
+
 #ifdef _WIN32
     static PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX
     get_info(LOGICAL_PROCESSOR_RELATIONSHIP relation, size_t& count)
@@ -16,7 +16,81 @@
 #  if __has_include(<version>)
 #    include <version>
 #  endif
-#  if defined(__cpp_lib_semaphore)
+#  if defined(__linux__)
+#    include <atomic>
+#    include <cerrno>
+#    include <cstdint>
+#    include <cstdlib>
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+namespace verona::rt::pal
+{
+  /**
+   * A binary semaphore on a futex.  Releasing it only enters the kernel if
+   * the thread acquiring it has gone to sleep.
+   */
+  class SemaphoreImpl
+  {
+    enum : uint32_t
+    {
+      Empty,
+      Available,
+      Sleeping
+    };
+
+    std::atomic<uint32_t> state_{Empty};
+
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+
+    long futex(int op, uint32_t value)
+    {
+      return syscall(
+        SYS_futex,
+        reinterpret_cast<uint32_t*>(&state_),
+        op,
+        value,
+        nullptr,
+        nullptr,
+        0);
+    }
+
+  public:
+    void release()
+    {
+      if (state_.exchange(Available, std::memory_order_release) == Sleeping)
+        futex(FUTEX_WAKE_PRIVATE, 1);
+    }
+
+    void acquire()
+    {
+      auto s = state_.load(std::memory_order_acquire);
+      while (true)
+      {
+        if (s == Available)
+        {
+          if (state_.compare_exchange_weak(
+                s, Empty, std::memory_order_acquire))
+            return;
+          continue;
+        }
+
+        if ((s == Empty) && !state_.compare_exchange_weak(s, Sleeping))
+          continue;
+
+        // Returns straight away if the state is no longer `Sleeping`.
+        if ((futex(FUTEX_WAIT_PRIVATE, Sleeping) != 0) &&
+            (errno != EAGAIN) && (errno != EINTR))
+        {
+          // Failed to wait on the futex.
+          abort();
+        }
+        s = state_.load(std::memory_order_acquire);
+      }
+    }
+  };
+} // namespace verona::rt::pal
+#  elif defined(__cpp_lib_semaphore)
 #    include <semaphore>
 namespace verona::rt::pal
 {
@@ -14,6 +14,8 @@ namespace verona::rt
   class ThreadPoolBuilder
   {
     std::list<PlatformThread> threads;
+    // Protects `threads` from `add_extra_thread`.
+    snmalloc::FlagWord threads_lock;
     size_t thread_count;
     size_t index = 0;
 
@@ -63,22 +65,44 @@ namespace verona::rt
       index++;
     }
 
+    /**
+     * Add a thread once all of the threads have been added, from any of them.
+     */
+    template<typename... Args>
+    void add_extra_thread(size_t affinity, void (*body)(Args...), Args... args)
+    {
+      snmalloc::FlagLock lock(threads_lock);
+#ifdef USE_SYSTEMATIC_TESTING
+      UNUSED(affinity);
+      threads.emplace_back(body, args...);
+#else
+      threads.emplace_back(
+        &run_with_affinity<Args...>, affinity, body, args...);
+#endif
+    }
+
     /**
      * The destructor waits for all threads to finish, and
      * then tidies up.
      *
      *  The number of executions is one larger than the number of threads
-     * created as there is also the main thread.
+     * created as there is also the main thread.  Threads can still be added
+     * by the threads being joined.
      */
     ~ThreadPoolBuilder()
     {
       assert(index == thread_count + 1);
 
-      while (!threads.empty())
+      while (true)
       {
-        auto& thread = threads.front();
-        thread.join();
-        threads.pop_front();
+        std::list<PlatformThread> joining;
+        {
+          snmalloc::FlagLock lock(threads_lock);
+          if (threads.empty())
+            break;
+          joining.splice(joining.begin(), threads, threads.begin());
+        }
+        joining.front().join();
       }
     }
   };
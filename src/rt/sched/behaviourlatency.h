@@ -0,0 +1,238 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "behaviour.h"
+
+#include <atomic>
+#include <snmalloc/snmalloc.h>
+
+namespace verona::rt
+{
+  using namespace snmalloc;
+
+  /**
+   * A histogram of cycle counts.
+   *
+   * Each power of two range of values is split into `SUB_BUCKETS` equal
+   * buckets, as in an HDR histogram, so every value is recorded to within
+   * 1/`SUB_BUCKETS` of its size, whatever its magnitude.  Values can be
+   * recorded from any thread.
+   */
+  class LatencyHistogram
+  {
+  public:
+    static constexpr size_t SUB_BUCKET_BITS = 3;
+    static constexpr size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKETS =
+      (snmalloc::bits::BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  private:
+    std::atomic<uint64_t> counts[BUCKETS] = {};
+
+  public:
+    static size_t bucket(uint64_t value)
+    {
+      if (value < SUB_BUCKETS)
+        return value;
+
+      size_t top = snmalloc::bits::BITS - 1 - snmalloc::bits::clz(value);
+      size_t shift = top - SUB_BUCKET_BITS;
+      return ((shift + 1) * SUB_BUCKETS) + ((value >> shift) - SUB_BUCKETS);
+    }
+
+    /**
+     * The smallest value recorded in bucket `index`.
+     */
+    static uint64_t bucket_min(size_t index)
+    {
+      if (index < SUB_BUCKETS)
+        return index;
+
+      size_t shift = (index / SUB_BUCKETS) - 1;
+      return (uint64_t)(SUB_BUCKETS + (index % SUB_BUCKETS)) << shift;
+    }
+
+    void record(uint64_t value)
+    {
+      counts[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t count(size_t index) const
+    {
+      return counts[index].load(std::memory_order_relaxed);
+    }
+
+    uint64_t total() const
+    {
+      uint64_t result = 0;
+      for (size_t i = 0; i < BUCKETS; i++)
+        result += count(i);
+      return result;
+    }
+
+    /**
+     * Returns the smallest value of the bucket containing the `percent`th
+     * percentile, or 0 if nothing has been recorded.
+     */
+    uint64_t percentile(double percent) const
+    {
+      auto recorded = total();
+      if (recorded == 0)
+        return 0;
+
+      auto target = (uint64_t)((double)recorded * percent / 100.0);
+      if (target >= recorded)
+        target = recorded - 1;
+
+      uint64_t seen = 0;
+      for (size_t i = 0; i < BUCKETS; i++)
+      {
+        seen += count(i);
+        if (seen > target)
+          return bucket_min(i);
+      }
+
+      // Values were recorded while walking the buckets.
+      return bucket_min(BUCKETS - 1);
+    }
+  };
+
+  /**
+   * Histograms of where the time goes for each type of behaviour.
+   *
+   * When enabled, each behaviour records, in cycles:
+   *  - `queued`: from being scheduled until the first of its cowns is
+   *    acquired.
+   *  - `acquiring`: from then until the last of its cowns is acquired.
+   *  - `running`: how long its body took to run.
+   *
+   * Behaviours are told apart by their descriptor, so all of the `when`s with
+   * the same closure type share histograms.  Once `MAX_TYPES` types have been
+   * seen, further types are recorded together under a null descriptor.  A
+   * `VBehaviour` type's descriptor is `T::type_descriptor()`.
+   */
+  class BehaviourLatency
+  {
+  public:
+    static constexpr size_t MAX_TYPES = 256;
+
+    struct Histograms
+    {
+      const Behaviour::Descriptor* descriptor;
+      LatencyHistogram queued;
+      LatencyHistogram acquiring;
+      LatencyHistogram running;
+
+      Histograms(const Behaviour::Descriptor* descriptor)
+      : descriptor(descriptor)
+      {}
+    };
+
+  private:
+    std::atomic<bool> enabled{false};
+    std::atomic<Histograms*> types[MAX_TYPES] = {};
+    std::atomic<Histograms*> other{nullptr};
+
+    static BehaviourLatency& get()
+    {
+      static BehaviourLatency global;
+      return global;
+    }
+
+    static Histograms* make(std::atomic<Histograms*>& slot, Histograms* h)
+    {
+      Histograms* expected = nullptr;
+      if (slot.compare_exchange_strong(expected, h))
+        return h;
+
+      delete h;
+      return expected;
+    }
+
+    /**
+     * Find the histograms for a descriptor, adding them on first use.
+     */
+    static Histograms& find(const Behaviour::Descriptor* descriptor)
+    {
+      auto& b = get();
+      auto start = bits::hash((uintptr_t)descriptor) % MAX_TYPES;
+      for (size_t i = 0; i < MAX_TYPES; i++)
+      {
+        auto& slot = b.types[(start + i) % MAX_TYPES];
+        auto h = slot.load(std::memory_order_acquire);
+
+        if (h == nullptr)
+          h = make(slot, new Histograms(descriptor));
+
+        if (h->descriptor == descriptor)
+          return *h;
+      }
+
+      auto h = b.other.load(std::memory_order_acquire);
+      if (h == nullptr)
+        h = make(b.other, new Histograms(nullptr));
+      return *h;
+    }
+
+    /**
+     * The ticks from `from` to `to`, or zero if `to` is earlier.  The ticks
+     * can be read on different cores, whose counters may not agree.
+     */
+    static uint64_t elapsed(uint64_t from, uint64_t to)
+    {
+      return (to > from) ? (to - from) : 0;
+    }
+
+  public:
+    ~BehaviourLatency()
+    {
+      for (auto& slot : types)
+        delete slot.load();
+      delete other.load();
+    }
+
+    static void enable(bool enable)
+    {
+      get().enabled.store(enable, std::memory_order_relaxed);
+    }
+
+    static bool is_enabled()
+    {
+      return get().enabled.load(std::memory_order_relaxed);
+    }
+
+    static void record(
+      const Behaviour::Descriptor* descriptor,
+      uint64_t sent,
+      uint64_t first_acquired,
+      uint64_t started,
+      uint64_t finished)
+    {
+      auto& h = find(descriptor);
+      h.queued.record(elapsed(sent, first_acquired));
+      h.acquiring.record(elapsed(first_acquired, started));
+      h.running.record(elapsed(started, finished));
+    }
+
+    /**
+     * Calls `f` with the histograms of each type of behaviour seen so far.
+     * This can be called while behaviours are being recorded.
+     */
+    template<typename F>
+    static void for_each(F f)
+    {
+      auto& b = get();
+      for (auto& slot : b.types)
+      {
+        auto h = slot.load(std::memory_order_acquire);
+        if (h != nullptr)
+          f(*h);
+      }
+
+      auto h = b.other.load(std::memory_order_acquire);
+      if (h != nullptr)
+        f(*h);
+    }
+  };
+} // namespace verona::rt
@@ -2,7 +2,9 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 
+#include "locality.h"
 #include "mpmcq.h"
+#include "priority.h"
 #include "schedulerstats.h"
 
 #include <atomic>
@@ -15,10 +17,63 @@ namespace verona::rt
   {
   public:
     size_t affinity = 0;
+    // The position of this core in the ring, from 0.
+    size_t index = 0;
+    // Where `affinity` is in the machine's topology, see `locality`.
+    size_t numa_node = 0;
+    size_t complex = 0;
     T* token_cown = nullptr;
     MPMCQ<T> q;
+
+    /**
+     * A queue for the cowns of a priority level above `Normal`.  Its token
+     * marks each pass through the queue, see `dequeue`.
+     */
+    struct PriorityQueue
+    {
+      T* token;
+      MPMCQ<T> q;
+
+      PriorityQueue() : token{T::create_token_cown()}, q{token} {}
+
+      /**
+       * The token is returned by `MPMCQ::dequeue` with its bottom bit set.
+       */
+      bool is_token(T* cown)
+      {
+        return ((uintptr_t)cown & ~(uintptr_t)1) == (uintptr_t)token;
+      }
+    };
+
+    PriorityQueue priority_q[PRIORITY_LEVELS - 1];
+
     std::atomic<Core<T>*> next = nullptr;
 
+    /**
+     * Set when the thread servicing this core starts to retire, see
+     * `ThreadPool::set_active_cores`.  A retired core stays in the ring, so
+     * that pointers to it remain valid, but no new work is sent to it.  It is
+     * cleared if the core is given a thread again.
+     */
+    std::atomic<bool> retired = false;
+
+    /**
+     * The number of cowns pinned to this core that have not been collected,
+     * see `Cown::pin`.  The core is not retired while there are any, so that
+     * they stay on it.
+     */
+    std::atomic<size_t> pinned_cowns = 0;
+
+    /**
+     * Set when a thread puts a cown on these queues that may not have been
+     * scanned in the current LD cycle, see
+     * `SchedulerThread::check_unscanned`.  Like a thread's own
+     * `scheduled_unscanned_cown`, this stops the threads servicing this core
+     * voting that the cycle is done until they have been through their queues
+     * again.
+     */
+    std::atomic<bool> scheduled_unscanned_cown = false;
+
     /// Progress and synchronization between the threads.
     //  These counters represent progress on a CPU core, not necessarily on
     //  the core's queue. This is necessary to take into account core-stealing
@@ -50,6 +105,109 @@ namespace verona::rt
 
     ~Core() {}
 
+    /**
+     * The queue for cowns of priority `p`.
+     */
+    MPMCQ<T>& queue(Priority p)
+    {
+      if (p == Priority::Normal)
+        return q;
+
+      return priority_q[(size_t)p - 1].q;
+    }
+
+    /**
+     * Takes a cown, or the token of `q`, from the highest priority queue
+     * that has one.  This may spuriously fail, as `MPMCQ::dequeue` can.
+     *
+     * So that the higher levels cannot starve the lower ones, each time the
+     * token of a level is reached, the cown is taken from a lower level, as
+     * the token of `q` gives other cores a turn when stealing for fairness.
+     * So each pass through a level lets one cown from below run.
+     */
+    T* dequeue(Alloc& alloc)
+    {
+      T* cown;
+      return (dequeue_batch(alloc, &cown, 1) != 0) ? cown : nullptr;
+    }
+
+    /**
+     * As `dequeue`, but a cown taken from `q` is taken with up to `max - 1`
+     * more from behind it, see `MPMCQ::dequeue_batch`.  The cowns are written
+     * to `out`, and the number taken is returned.
+     */
+    size_t dequeue_batch(Alloc& alloc, T** out, size_t max)
+    {
+      for (size_t pass = 0; pass < 2; pass++)
+      {
+        bool yielded = false;
+        for (size_t level = PRIORITY_LEVELS - 1; level > 0; level--)
+        {
+          auto& pq = priority_q[level - 1];
+          T* cown = pq.q.dequeue(alloc);
+          if (cown == nullptr)
+            continue;
+
+          if (!pq.is_token(cown))
+          {
+            out[0] = cown;
+            return 1;
+          }
+
+          pq.q.enqueue(alloc, cown);
+          yielded = true;
+        }
+
+        size_t count = q.dequeue_batch(alloc, out, max);
+        if ((count != 0) || !yielded)
+          return count;
+
+        // Nothing below the levels that yielded, so go round again.
+      }
+
+      return 0;
+    }
+
+    /**
+     * Returns true if nothing older than this call is in any of the queues,
+     * see `MPMCQ::nothing_old`.
+     */
+    bool nothing_old()
+    {
+      for (auto& pq : priority_q)
+      {
+        if (!pq.q.nothing_old())
+          return false;
+      }
+
+      return q.nothing_old();
+    }
+
+    /**
+     * Destroys the queues, which must be empty.
+     */
+    void destroy_queues(Alloc& alloc)
+    {
+      q.destroy(alloc);
+      for (auto& pq : priority_q)
+        pq.q.destroy(alloc);
+    }
+
+    /**
+     * Returns how close the CPU this core runs on is to the CPU `that` runs
+     * on.
+     */
+    Locality locality(const Core<T>* that) const
+    {
+      if (numa_node != that->numa_node)
+        return Locality::Remote;
+
+      if (complex != that->complex)
+        return Locality::Node;
+
+      return Locality::Complex;
+    }
+
     void collect(Alloc& alloc)
     {
       T* head = list.exchange(nullptr);
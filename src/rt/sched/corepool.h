@@ -23,18 +23,25 @@ namespace verona::rt
 
     inline static Singleton<Topology, &Topology::init> topology;
     Core<T>* first_core = nullptr;
-    size_t core_count = 0;
+    std::atomic<size_t> core_count = 0;
+
+    /// The number of cores that are not retired.
+    std::atomic<size_t> active_count = 0;
 
   public:
     void init(size_t count)
     {
       core_count = count;
+      active_count = count;
       first_core = new Core<T>;
       Core<T>* t = first_core;
 
       while (true)
       {
         t->affinity = topology.get().get(count);
+        t->index = core_count - count;
+        t->numa_node = topology.get().get_numa_node(count);
+        t->complex = topology.get().get_complex(count);
         if (count > 1)
         {
           t->next = new Core<T>;
@@ -49,6 +56,60 @@ namespace verona::rt
       }
     }
 
+    /**
+     * Returns a core for a thread added while running, reusing a retired core
+     * if its thread has finished, or else adding one to the end of the ring.
+     * Must be called holding the thread pool lock.
+     */
+    Core<T>* add()
+    {
+      active_count++;
+
+      Core<T>* t = first_core;
+      Core<T>* last;
+      do
+      {
+        if (t->retired && (t->servicing_threads == 0))
+        {
+          t->total_cowns = 0;
+          t->free_cowns = 0;
+          t->retired = false;
+          return t;
+        }
+        last = t;
+        t = t->next;
+      } while (t != first_core);
+
+      size_t count = core_count + 1;
+      t = new Core<T>;
+      t->affinity = topology.get().get(count);
+      t->index = core_count;
+      t->numa_node = topology.get().get_numa_node(count);
+      t->complex = topology.get().get_complex(count);
+      t->next = first_core;
+      last->next = t;
+      core_count = count;
+      return t;
+    }
+
+    /**
+     * Destroys the queues of the retired cores, which have no thread to do so
+     * at teardown.
+     */
+    void destroy_retired_queues(Alloc& alloc)
+    {
+      if (first_core == nullptr)
+        return;
+
+      Core<T>* core = first_core;
+      do
+      {
+        if (core->retired)
+          core->destroy_queues(alloc);
+        core = core->next;
+      } while (core != first_core);
+    }
+
     void clear()
     {
       if (first_core == nullptr)
@@ -67,6 +128,7 @@ namespace verona::rt
       first_core = nullptr;
       assert(count == core_count);
       core_count = 0;
+      active_count = 0;
     }
 
     ~CorePool()
@@ -8,6 +8,7 @@
 #include "../test/logging.h"
 #include "../test/systematic.h"
 #include "base_noticeboard.h"
+#include "behaviourlatency.h"
 #include "core.h"
 #include "multimessage.h"
 #include "schedulerthread.h"
@@ -27,29 +28,6 @@ namespace verona::rt
     Systematic::yield();
   }
 
-  struct EnqueueLock
-  {
-    std::atomic<bool> locked = false;
-
-    void lock()
-    {
-      auto u = false;
-      while (!locked.compare_exchange_strong(u, true))
-      {
-        u = false;
-        while (locked)
-        {
-          yield();
-        }
-      }
-    }
-
-    void unlock()
-    {
-      locked.store(false, std::memory_order_release);
-    }
-  };
-
   /**
    * A cown, or concurrent owner, encapsulates a set of resources that may be
    * accessed by a single (scheduler) thread at a time when writing, or
@@ -75,18 +53,111 @@ namespace verona::rt
    * read more before a write).
    */
 
+  /**
+   * Reader counts spread over one cache line per core, for a cown marked
+   * read-mostly, see `Cown::mark_read_mostly`.  A reader is added on the core
+   * that acquires the cown for it, and removed on the core that ran it, so a
+   * single line's count can be negative, but their total cannot.
+   *
+   * Readers are only added by the thread that acquires the cown, which is
+   * the thread that then checks for readers before a write.  So while a write
+   * is waiting, the counts only fall, and a sum read line by line can only
+   * overestimate the readers.
+   */
+  class ReaderSlots
+  {
+    static constexpr size_t CACHE_LINE_SIZE = SchedulerStats::CACHE_LINE_SIZE;
+
+    struct Slot
+    {
+      std::atomic<ptrdiff_t> count{0};
+      std::byte padding[CACHE_LINE_SIZE - sizeof(count)];
+    };
+
+    // The number of slots, a power of two.  The slots follow on their own
+    // cache lines.
+    size_t slot_count;
+
+    ReaderSlots(size_t slot_count) : slot_count(slot_count)
+    {
+      for (size_t i = 0; i < slot_count; i++)
+        new (slot(i)) Slot;
+    }
+
+    Slot* slot(size_t index)
+    {
+      return pointer_offset<Slot>(
+        this, (1 + (index & (slot_count - 1))) * sizeof(Slot));
+    }
+
+    static size_t size(size_t slot_count)
+    {
+      return (1 + slot_count) * sizeof(Slot);
+    }
+
+  public:
+    static ReaderSlots* make(Alloc& alloc, size_t cores)
+    {
+      auto slot_count = bits::next_pow2(std::max<size_t>(cores, 1));
+      return new (alloc.alloc(size(slot_count))) ReaderSlots(slot_count);
+    }
+
+    void dealloc(Alloc& alloc)
+    {
+      alloc.dealloc(this, size(slot_count));
+    }
+
+    void add(size_t index)
+    {
+      slot(index)->count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void remove(size_t index)
+    {
+      slot(index)->count.fetch_sub(1);
+    }
+
+    bool empty()
+    {
+      ptrdiff_t total = 0;
+      for (size_t i = 0; i < slot_count; i++)
+        total += slot(i)->count.load();
+      return total == 0;
+    }
+  };
+
   struct ReadRefCount
   {
     std::atomic<size_t> count{0};
 
-    void add_read()
+    // The readers of a read-mostly cown, which are then not counted in
+    // `count`.  Its bottom bit still signals a waiting write.
+    ReaderSlots* slots = nullptr;
+
+    // `slot` is the index of the calling thread's core, see `ReaderSlots`.
+    void add_read(size_t slot)
     {
+      if (slots != nullptr)
+      {
+        slots->add(slot);
+        return;
+      }
+
       count.fetch_add(2);
     }
 
     // true means last reader and writer is waiting, false otherwise
-    bool release_read()
+    bool release_read(size_t slot)
     {
+      if (slots != nullptr)
+      {
+        slots->remove(slot);
+        Systematic::yield();
+        // Every reader that sees the write waiting and no readers left tries
+        // to hand over to the writer, but only one succeeds.
+        return (count.load() == 1) && slots->empty() && clear_write();
+      }
+
       if (count.fetch_sub(2) == 3)
       {
         Systematic::yield();
@@ -99,6 +170,18 @@ namespace verona::rt
 
     bool try_write()
     {
+      if (slots != nullptr)
+      {
+        if (slots->empty())
+          return true;
+
+        // Mark a pending write, then check again for a last reader that
+        // finished before it could see the mark.
+        count.store(1);
+        Systematic::yield();
+        return slots->empty() && clear_write();
+      }
+
       if (count.load(std::memory_order_relaxed) == 0)
         return true;
 
@@ -114,6 +197,30 @@ namespace verona::rt
       assert(count.load() == 0);
       return true;
     }
+
+    /**
+     * Spread the readers over a cache line per core, see `ReaderSlots`.
+     */
+    void distribute(Alloc& alloc, size_t cores)
+    {
+      assert(count.load() == 0);
+      if (slots == nullptr)
+        slots = ReaderSlots::make(alloc, cores);
+    }
+
+    void dealloc(Alloc& alloc)
+    {
+      if (slots != nullptr)
+        slots->dealloc(alloc);
+    }
+
+  private:
+    // Clears a pending write, returning false if another thread already has.
+    bool clear_write()
+    {
+      size_t pending = 1;
+      return count.compare_exchange_strong(pending, 0);
+    }
   };
 
   class Cown : public Object
@@ -168,28 +275,88 @@ namespace verona::rt
 
     static constexpr auto NO_EPOCH_SET = (std::numeric_limits<uint64_t>::max)();
 
+    // The most locked messages that `fast_send` keeps on the stack.
+    static constexpr size_t HELD_INLINE = 16;
+
+    /*
+     * The fields are grouped by the threads that write them, so that threads
+     * writing different groups do not contend for the same cache line:
+     *
+     *   - the reference count in the object header, `weak_count` and the
+     *     `back` of `queue` are written by threads holding references to the
+     *     cown and sending it messages,
+     *   - the `front` of `queue` and the scheduling fields after it are written
+     *     by the thread running the cown, or scheduling it,
+     *   - `read_ref_count` is written by every thread running a behaviour that
+     *     reads the cown.
+     *
+     * Each group starts a cache line, counted from the start of the
+     * allocation, which `ALLOCATION_ALIGNMENT` puts on a line boundary.  This
+     * takes a cown from 96 to 192 bytes, so building with `USE_COMPACT_COWNS`
+     * drops the padding, for deployments with millions of mostly idle cowns.
+     * See `test/perf/false_sharing` for the difference it makes.
+     */
+#ifdef USE_COMPACT_COWNS
+  public:
+    static constexpr size_t ALLOCATION_ALIGNMENT = Object::ALIGNMENT;
+
+  private:
+#else
+  public:
+    static constexpr size_t ALLOCATION_ALIGNMENT =
+      SchedulerStats::CACHE_LINE_SIZE;
+
+  private:
+#endif
+
+    /**
+     * Cown's weak reference count.  This keeps the cown itself alive, but not
+     * the data it can reach.  Weak reference can be promoted to strong, if a
+     * strong reference still exists.
+     **/
+    std::atomic<size_t> weak_count{1};
+
+#ifndef USE_COMPACT_COWNS
+    // Fills the first line, so that the `back` of `queue` ends it.
+    std::byte producer_padding
+      [ALLOCATION_ALIGNMENT - sizeof(Object::Header) - sizeof(weak_count) -
+       sizeof(MultiMessage*)];
+#endif
+
+    // The `back` of the queue is written by senders, and the `front` by the
+    // thread running the cown, see `MPSCQ`.
+    verona::rt::MPSCQ<MultiMessage> queue{};
+
     union
     {
       std::atomic<Cown*> next_in_queue;
       uint64_t epoch_when_popped{NO_EPOCH_SET};
     };
 
-    // Seven pointer overhead compared to an object.
-    verona::rt::MPSCQ<MultiMessage> queue{};
-
     // Used for garbage collection of cyclic cowns only.
     // Uses the bottom bit to indicate the cown has been collected
     // If the object is collected by the leak detector, we should not
     // collect again when the weak reference count hits 0.
+    // The next bit indicates the cown is pinned to its core, see `pin`.
     std::atomic<uintptr_t> core_status{0};
     Cown* next{nullptr};
 
     /**
-     * Cown's weak reference count.  This keeps the cown itself alive, but not
-     * the data it can reach.  Weak reference can be promoted to strong, if a
-     * strong reference still exists.
-     **/
-    std::atomic<size_t> weak_count{1};
+     * Moving average of the cycles this cown takes to handle a message, used
+     * to size its batches, see `ThreadPool::set_batch_limit`.
+     */
+    uint64_t message_cycles = 0;
+
+    std::atomic<Priority> priority{Priority::Normal};
+
+#ifndef USE_COMPACT_COWNS
+    // Fills the second line, which started with the `front` of `queue`.
+    std::byte consumer_padding
+      [ALLOCATION_ALIGNMENT -
+       (sizeof(MultiMessage*) + sizeof(epoch_when_popped) +
+        sizeof(core_status) + sizeof(next) + sizeof(message_cycles) +
+        sizeof(priority))];
+#endif
 
     /*
      * Cown's read ref count.
@@ -198,7 +365,15 @@ namespace verona::rt
      */
     ReadRefCount read_ref_count;
 
-    EnqueueLock enqueue_lock;
+    /**
+     * The reader slot of the calling thread, for a read-mostly cown, see
+     * `ReaderSlots`.
+     */
+    static size_t reader_slot()
+    {
+      CownThread* t = Scheduler::local();
+      return ((t == nullptr) || (t->core == nullptr)) ? 0 : t->core->index;
+    }
 
     static Cown* create_token_cown()
     {
@@ -213,13 +388,26 @@ namespace verona::rt
     }
 
     static constexpr uintptr_t collected_mask = 1;
-    static constexpr uintptr_t thread_mask = ~collected_mask;
+    static constexpr uintptr_t pinned_mask = 2;
+    static constexpr uintptr_t thread_mask = ~(collected_mask | pinned_mask);
 
     void set_owning_core(Core<Cown>* owner)
     {
       core_status = (uintptr_t)owner;
     }
 
+    /**
+     * Moves this cown to be owned by `owner`, keeping its other bits, which
+     * may be set concurrently.
+     */
+    void move_to_core(Core<Cown>* owner)
+    {
+      auto status = core_status.load(std::memory_order_relaxed);
+      while (!core_status.compare_exchange_weak(
+        status, (status & ~thread_mask) | (uintptr_t)owner))
+      {}
+    }
+
     void mark_collected()
     {
       core_status |= 1;
@@ -237,7 +425,110 @@ namespace verona::rt
         Core<Cown>*)(core_status.load(std::memory_order_relaxed) & thread_mask);
     }
 
+    /**
+     * Pin this cown to `core`, see `pin`.  A cown is in the list of cowns of
+     * the core that owns it, so one that already has an owner cannot be
+     * moved to another core here.
+     */
+    void pin_to(Core<Cown>* core)
+    {
+      Core<Cown>* owner = owning_core();
+      if (owner == nullptr)
+      {
+        set_owning_core(core);
+        core->add_cown(this);
+        core->total_cowns++;
+      }
+      else if (owner != core)
+      {
+        Logging::cout() << "Cown " << this << " owned by core "
+                        << owner->affinity << " cannot be pinned to core "
+                        << core->affinity << Logging::endl;
+        abort();
+      }
+
+      Logging::cout() << "Cown " << this << " pinned to core "
+                      << core->affinity << Logging::endl;
+      if ((core_status.fetch_or(pinned_mask) & pinned_mask) == 0)
+        core->pinned_cowns++;
+    }
+
   public:
+    /**
+     * Pin this cown to its core, that of the scheduler thread that created
+     * it, or the first core for a cown created off the runtime's threads.
+     *
+     * A pinned cown is only run by the threads servicing its core, and is
+     * never stolen, so its behaviours all run on that core.  This is for
+     * cowns wrapping state that is tied to a thread, such as a thread-affine
+     * library handle or a hot working set.  A behaviour that also requires
+     * other cowns runs on the core of its last pinned cown, once the others
+     * are acquired, so should not require cowns pinned to different cores.
+     * It is still ordered with the other behaviours on each of its cowns.
+     * The core is not retired until the cown is collected, so that it keeps
+     * the cown, see `ThreadPool::set_active_cores`.
+     *
+     * Must be called before any behaviour is scheduled on this cown.
+     */
+    void pin()
+    {
+      Core<Cown>* core = owning_core();
+      pin_to(core == nullptr ? Scheduler::core(0) : core);
+    }
+
+    /**
+     * Pin this cown to the `index`th core, which the `index`th scheduler
+     * thread runs on, see `pin()`.  A cown created on a scheduler thread
+     * belongs to that thread's core, so this aborts if that is not the
+     * `index`th core.
+     */
+    void pin(size_t index)
+    {
+      pin_to(Scheduler::core(index));
+    }
+
+    bool is_pinned()
+    {
+      return (core_status.load(std::memory_order_relaxed) & pinned_mask) != 0;
+    }
+
+    /**
+     * Count the readers of this cown on a cache line per core, rather than on
+     * one line that every reader updates, so that read-only behaviours on
+     * many cores do not contend.  A write then has to check every line for
+     * readers, and the lines take space, so this is for cowns that are read
+     * far more often than they are written.  See `ReaderSlots`.
+     *
+     * Must be called before any behaviour is scheduled on this cown.
+     */
+    void mark_read_mostly()
+    {
+      read_ref_count.distribute(
+        ThreadAlloc::get(), Scheduler::get_active_cores());
+    }
+
+    bool is_read_mostly()
+    {
+      return read_ref_count.slots != nullptr;
+    }
+
+    /**
+     * Set the priority this cown is scheduled with, from the next time it is
+     * scheduled.  A core runs its higher priority cowns first, and other
+     * cores steal them first, so a latency critical cown does not wait
+     * behind the bulk of the work.  The lower levels still get a turn, see
+     * `Core::dequeue`.
+     */
+    void set_priority(Priority p)
+    {
+      priority.store(p, std::memory_order_relaxed);
+    }
+
+    Priority get_priority()
+    {
+      return priority.load(std::memory_order_relaxed);
+    }
+
 #ifdef USE_SYSTEMATIC_TESTING_WEAK_NOTICEBOARDS
     std::vector<BaseNoticeboard*> noticeboards;
 
@@ -434,6 +725,12 @@ namespace verona::rt
       // queue on send, or when rescheduling after a multi-message.
       CownThread* t = Scheduler::local();
 
+      if (is_pinned() && ((t == nullptr) || (t->core != owning_core())))
+      {
+        CownThread::schedule_pinned(this);
+        return;
+      }
+
       if (t != nullptr)
       {
         t->schedule_fifo(this);
@@ -458,6 +755,9 @@ namespace verona::rt
 
     void dealloc(Alloc& alloc)
     {
+      // Readers may still be releasing the cown after it is collected, so
+      // their slots are kept until now.
+      read_ref_count.dealloc(alloc);
       Object::dealloc(alloc);
       yield();
     }
@@ -541,29 +841,25 @@ namespace verona::rt
      *     message.
      * (2) We sent the message to the last cown. There are no further cowns to
      *     acquire, so we schedule the last cown so it can handle the
-     *     multi-message behaviour.
-     *     TODO: It would be semantically valid to execute the behaviour without
-     *     rescheduling. However, for fairness, it is better to reschedule in
-     *     case the behaviour executes for a very long time.
+     *     multi-message behaviour. If the scheduler thread has inline budget
+     *     left, we handle the message immediately instead, see
+     *     `try_run_inline`.
      **/
     static void fast_send(MultiMessage::Body* body, EpochMark epoch)
     {
       auto& alloc = ThreadAlloc::get();
       const auto last = body->count - 1;
 
-      // First acquire all the locks if a multimessage
-      if (body->count > 1)
-      {
-        for (size_t i = 0; i < body->count; i++)
-        {
-          auto next = body->get_requests_array()[i];
-          Logging::cout() << "Will try to acquire lock " << next.cown()
-                          << Logging::endl;
-          next.cown()->enqueue_lock.lock();
-          yield();
-          Logging::cout() << "Acquired lock " << next.cown() << Logging::endl;
-        }
-      }
+      // The messages are enqueued locked, in the global order of the cowns, and
+      // are all unlocked once the last one is enqueued.  A later locked enqueue
+      // on any of these cowns waits for the unlock before moving on to its next
+      // cown, so all multi-messages are enqueued in a consistent order on all
+      // of their cowns, without taking a lock per cown.  The locked messages
+      // are kept on the stack until then, unless there are many of them.
+      MultiMessage* held_inline[HELD_INLINE];
+      auto held = (last <= HELD_INLINE) ?
+        held_inline :
+        (MultiMessage**)alloc.alloc(last * sizeof(MultiMessage*));
 
       size_t loop_end = body->count;
       for (size_t i = 0; i < loop_end; i++)
@@ -574,9 +870,19 @@ namespace verona::rt
                         << ", index " << i << " loop end " << loop_end
                         << Logging::endl;
 
-        auto needs_sched = next->try_fast_send(m);
-        if (loop_end > 1)
-          next->enqueue_lock.unlock();
+        auto needs_sched = next->try_fast_send(m, i == last);
+        if (i != last)
+        {
+          held[i] = m;
+        }
+        else
+        {
+          for (size_t j = 0; j < last; j++)
+            MPSCQ<MultiMessage>::unlock(held[j]);
+
+          if (held != held_inline)
+            alloc.dealloc(held, last * sizeof(MultiMessage*));
+        }
 
         if (!needs_sched)
         {
@@ -589,11 +895,20 @@ namespace verona::rt
         Logging::cout() << "Will schedule cown " << next << Logging::endl;
         if (i == last)
         {
-          next->schedule();
+          if (!next->try_run_inline(m))
+            next->schedule();
           return;
         }
 
-        body->exec_count_down.fetch_sub(1);
+        // The cown that runs the behaviour is only acquired on its own core,
+        // see `acquire_pinned`.
+        if (next == pinned_runner(body))
+        {
+          next->schedule();
+          continue;
+        }
+
+        body->acquire_one();
 
         // The cown was asleep, so we have acquired it now. Dequeue the
         // message because we want to handle it now. Note that after
@@ -608,26 +923,70 @@ namespace verona::rt
         Request r = body->get_requests_array()[i];
         if (r.is_read())
         {
-          r.cown()->read_ref_count.add_read();
+          r.cown()->read_ref_count.add_read(reader_slot());
           r.cown()->schedule();
         }
       }
     }
 
+    /**
+     * Returns the cown whose core runs a behaviour on more than one cown, the
+     * last of its pinned cowns, or nullptr if none of them are pinned, see
+     * `pin`.
+     **/
+    static Cown* pinned_runner(MessageBody* body)
+    {
+      if (body->count == 1)
+        return nullptr;
+
+      for (size_t i = body->count; i > 0; i--)
+      {
+        auto* cown = body->get_requests_array()[i - 1].cown();
+        if ((cown != nullptr) && cown->is_pinned())
+          return cown;
+      }
+      return nullptr;
+    }
+
+    /**
+     * Called on its core by the cown that runs `body`, see `pinned_runner`,
+     * with the message for `body` at the head of its queue.  Counts this cown
+     * as acquired, the first time, and returns true once the other cowns have
+     * been acquired as well.  Until then the message is left in the queue, so
+     * this cown handles nothing else, and the last of the other cowns to be
+     * acquired schedules it again.
+     **/
+    bool acquire_pinned(MessageBody* body)
+    {
+      if (body->exec_count_down.load() == 0)
+        return true;
+
+      if (body->acquire_one() == 1)
+        return true;
+
+      Logging::cout() << "Cown " << this << " waits for the other cowns of "
+                      << body << Logging::endl;
+      return false;
+    }
+
     /**
      * This method implements an optimized multi-message send to a cown. A
      * sleeping cown will not be reschdeuled because we want to immediately
      * acquire the cown without going through the scheduler queue. Returns true
      * if the cown was asleep and needs scheduling; returns false otherwise.
+     *
+     * Unless this is the `last` message of the multi-message, it is left
+     * locked, see `MPSCQ::enqueue_locked`.
      **/
-    bool try_fast_send(MultiMessage* m)
+    bool try_fast_send(MultiMessage* m, bool last)
     {
 #ifdef USE_SYSTEMATIC_TESTING_WEAK_NOTICEBOARDS
       flush_all(ThreadAlloc::get());
       yield();
 #endif
       Logging::cout() << "Enqueue MultiMessage " << m << Logging::endl;
-      bool needs_scheduling = queue.enqueue(m);
+      bool needs_scheduling =
+        last ? queue.enqueue(m) : queue.enqueue_locked(m);
       Logging::cout() << "Enqueued MultiMessage " << m << " needs scheduling? "
                       << needs_scheduling << Logging::endl;
       yield();
@@ -638,6 +997,86 @@ namespace verona::rt
       return needs_scheduling;
     }
 
+    /**
+     * As `try_fast_send`, for the messages from `first` to `last` of a
+     * `Batch`, which are already linked together.
+     **/
+    bool try_fast_send_chain(MultiMessage* first, MultiMessage* last)
+    {
+#ifdef USE_SYSTEMATIC_TESTING_WEAK_NOTICEBOARDS
+      flush_all(ThreadAlloc::get());
+      yield();
+#endif
+      Logging::cout() << "Enqueue MultiMessages " << first << " to " << last
+                      << Logging::endl;
+      bool needs_scheduling = queue.enqueue_chain(first, last);
+      Logging::cout() << "Enqueued MultiMessages " << first << " to " << last
+                      << " needs scheduling? " << needs_scheduling
+                      << Logging::endl;
+      yield();
+      if (needs_scheduling)
+      {
+        Cown::acquire(this);
+      }
+      return needs_scheduling;
+    }
+
+    /**
+     * Handle the message `m`, that has just been sent to this cown and woken
+     * it up, on the sending scheduler thread, rather than scheduling the cown.
+     * Saves a round trip through the scheduler queue for the last cown of a
+     * behaviour, at the cost of delaying the behaviour that sent `m`, so is
+     * bounded by `ThreadPool::set_inline_budget`.
+     *
+     * Returns false if the cown must be scheduled instead.
+     **/
+    bool try_run_inline(MultiMessage* m)
+    {
+      CownThread* t = Scheduler::local();
+      if ((t == nullptr) || (owning_core() == nullptr) || !t->can_run_inline())
+        return false;
+
+      if (is_pinned() && (owning_core() != t->core))
+        return false;
+
+      // In the rare case that a message before `m` has not been made ready
+      // yet, `m` cannot be dequeued until it is, see `MPSCQ::ready`.
+      if (queue.peek() != m)
+        return false;
+
+      // As in `run`, a write must wait for the current readers, the last of
+      // which will schedule this cown.
+      Request* request = m->get_body()->get_requests_array();
+      while (request->cown() != this)
+        request++;
+      if (!request->is_read() && !read_ref_count.try_write())
+        return true;
+
+      auto* body = m->get_body();
+      if ((pinned_runner(body) == this) && !acquire_pinned(body))
+        return true;
+
+      auto& alloc = ThreadAlloc::get();
+      const auto* m2 = queue.dequeue(alloc);
+      assert(m == m2);
+      UNUSED(m2);
+
+      Logging::cout() << "Running MultiMessage " << m << " inline on cown "
+                      << this << Logging::endl;
+      t->core->stats.run_inline();
+
+      auto* outer = t->message_body;
+      t->inline_count++;
+      t->inline_depth++;
+      bool reschedule = run_step(m);
+      t->inline_depth--;
+      t->message_body = outer;
+
+      if (reschedule)
+        schedule();
+      return true;
+    }
+
     /**
      * Execute the behaviour of the given multi-message.
      *
@@ -677,10 +1116,22 @@ namespace verona::rt
         request++;
 
       bool schedule_after_behaviour = true;
+      if (request->is_read())
+        read_ref_count.add_read(reader_slot());
+
+      // The cown that runs a behaviour on its core has already been counted,
+      // and is only run once the rest have been, see `acquire_pinned`.
+      auto* runner = pinned_runner(&body);
+      bool last = (runner == this) || (body.acquire_one() == 1);
+      if (last && (runner != nullptr) && (runner != this))
+      {
+        runner->schedule();
+        last = false;
+      }
+
       if (request->is_read())
       {
-        read_ref_count.add_read();
-        if (body.exec_count_down.fetch_sub(1) > 1)
+        if (!last)
           return true;
         else
           // In this case, this thread will execute the behaviour
@@ -690,7 +1141,7 @@ namespace verona::rt
       }
       else
       { // request->mode == AccessMode::WRITE
-        if (body.exec_count_down.fetch_sub(1) > 1)
+        if (!last)
           return false;
       }
 
@@ -739,7 +1190,24 @@ namespace verona::rt
         schedule();
 
       // Run the behaviour.
-      body.get_behaviour().f();
+      auto body_size = body.size();
+      Scheduler::local()->core->stats.run();
+      if (body.sent_tick == 0)
+      {
+        body.get_behaviour().f();
+      }
+      else
+      {
+        auto* descriptor = body.get_behaviour().get_descriptor();
+        auto started = Aal::tick();
+        body.get_behaviour().f();
+        BehaviourLatency::record(
+          descriptor,
+          body.sent_tick,
+          body.acquired_tick.load(std::memory_order_relaxed),
+          started,
+          Aal::tick());
+      }
 
       for (size_t i = 0; i < body.count; i++)
       {
@@ -769,7 +1237,7 @@ namespace verona::rt
             //   thread
             //     (overwriting the previous decision to stop processing this
             //     cown).
-            if (cown->read_ref_count.release_read())
+            if (cown->read_ref_count.release_read(reader_slot()))
             {
               if (cown != this)
                 cown->schedule();
@@ -780,7 +1248,7 @@ namespace verona::rt
         }
       }
 
-      alloc.dealloc(&body);
+      MultiMessage::Body::dealloc(alloc, &body, body_size);
 
       return schedule_after_behaviour;
     }
@@ -797,23 +1265,27 @@ namespace verona::rt
     }
 
     template<
-      class Behaviour,
+      class Be,
       TransferOwnership transfer = NoTransfer,
       typename... Args>
     static void schedule(size_t count, Cown** cowns, Args&&... args)
     {
-      // TODO Remove vector allocation here.  This is a temporary fix to
-      // as we transition to using Request through the code base.
+      static_assert(std::is_base_of_v<Behaviour, Be>);
+      Logging::cout() << "Schedule behaviour of type: " << typeid(Be).name()
+                      << Logging::endl;
+
       auto& alloc = ThreadAlloc::get();
-      Request* requests = (Request*)alloc.alloc(count * sizeof(Request));
 
+      auto body =
+        MultiMessage::Body::make<Be>(alloc, count, std::forward<Args>(args)...);
+
+      // Write the requests straight into the body, they are sorted in place
+      // by schedule_body.
+      auto* requests = body->get_requests_array();
       for (size_t i = 0; i < count; ++i)
         requests[i] = Request::write(cowns[i]);
 
-      schedule<Behaviour, transfer, Args...>(
-        count, requests, std::forward<Args>(args)...);
-
-      alloc.dealloc(requests);
+      schedule_body<transfer>(body);
     }
 
     /**
@@ -838,8 +1310,138 @@ namespace verona::rt
       auto body =
         MultiMessage::Body::make<Be>(alloc, count, std::forward<Args>(args)...);
 
+      memcpy(body->get_requests_array(), requests, count * sizeof(Request));
+
+      schedule_body<transfer>(body);
+    }
+
+    /**
+     * Behaviours on a single cown, that are scheduled together.
+     *
+     * `add` builds the message for each behaviour, and `send` enqueues all of
+     * them on the cown with a single exchange, see `MPSCQ::enqueue_chain`, and
+     * schedules the cown at most once.  A thread that sends many behaviours to
+     * one cown then contends for the back of its queue once per batch, rather
+     * than once per behaviour.
+     *
+     * The behaviours run in the order they were added, after any behaviour
+     * scheduled on the cown before `send`, including those scheduled after
+     * they were added.  A batch must be sent by the behaviour, or external
+     * thread, that built it, as its messages are sent in that behaviour's
+     * epoch.  A batch that is destroyed before it is sent sends its
+     * behaviours then.
+     **/
+    class Batch
+    {
+      Request request;
+      EpochMark epoch = EpochMark::EPOCH_NONE;
+      MultiMessage* first = nullptr;
+      MultiMessage* last = nullptr;
+      size_t count = 0;
+
+    public:
+      Batch(Request request) : request(request) {}
+
+      Batch(Cown* cown) : Batch(Request::write(cown)) {}
+
+      Batch(const Batch&) = delete;
+      Batch& operator=(const Batch&) = delete;
+
+      ~Batch()
+      {
+        send();
+      }
+
+      /**
+       * Add a behaviour to the batch, as with `Cown::schedule`.
+       **/
+      template<
+        class Be,
+        TransferOwnership transfer = NoTransfer,
+        typename... Args>
+      void add(Args&&... args)
+      {
+        static_assert(std::is_base_of_v<Behaviour, Be>);
+        Logging::cout() << "Batch behaviour of type: " << typeid(Be).name()
+                        << Logging::endl;
+
+        auto& alloc = ThreadAlloc::get();
+
+        auto body =
+          MultiMessage::Body::make<Be>(alloc, 1, std::forward<Args>(args)...);
+        *body->get_requests_array() = request;
+        epoch = prepare_body<transfer>(body);
+
+        auto m = MultiMessage::make_message(alloc, body, epoch);
+        if (last == nullptr)
+          first = m;
+        else
+          last->next.store(m, std::memory_order_relaxed);
+        last = m;
+        count++;
+      }
+
+      /**
+       * The number of behaviours added since the batch was last sent.
+       **/
+      size_t size() const
+      {
+        return count;
+      }
+
+      /**
+       * Schedule the behaviours added to the batch.  The batch is then empty,
+       * and can be reused.
+       **/
+      void send()
+      {
+        if (first == nullptr)
+          return;
+
+        auto* cown = request.cown();
+        Logging::cout() << "Batch of " << count << " behaviours on " << cown
+                        << Logging::endl;
+
+        // Once enqueued, the messages may be run and deallocated.
+        auto* m = first;
+        auto needs_sched = cown->try_fast_send_chain(first, last);
+        first = nullptr;
+        last = nullptr;
+        count = 0;
+
+        if (needs_sched && !cown->try_run_inline(m))
+          cown->schedule();
+      }
+    };
+
+  private:
+    /**
+     * Sorts the requests of a fully constructed message body, and sends it to
+     * the first cown we want to acquire.
+     **/
+    template<TransferOwnership transfer>
+    static void schedule_body(MessageBody* body)
+    {
+      auto epoch = prepare_body<transfer>(body);
+
+      // Try to acquire as many cowns as possible without rescheduling,
+      // starting from the beginning.
+      fast_send(body, epoch);
+    }
+
+    /**
+     * Sorts the requests of a fully constructed message body, and takes the
+     * references and records the statistics for sending it.  Returns the
+     * epoch to send its messages in.
+     **/
+    template<TransferOwnership transfer>
+    static EpochMark prepare_body(MessageBody* body)
+    {
+      if (BehaviourLatency::is_enabled())
+        body->sent_tick = Aal::tick();
+
+      const size_t count = body->count;
       auto* sort = body->get_requests_array();
-      memcpy(sort, requests, count * sizeof(Request));
 
 #ifdef USE_SYSTEMATIC_TESTING
       std::sort(&sort[0], &sort[count], [](Request& a, Request& b) {
@@ -860,7 +1462,8 @@ namespace verona::rt
       // TODO what if this thread is external.
       //  EPOCH_A okay as currently only sending externally, before we start
       //  and thus its okay.
-      //  Need to use another value when we add pinned cowns.
+      //  Pinned cowns are run by scheduler threads, so send with the epoch of
+      //  the thread like any other cown.
       auto sched = Scheduler::local();
       auto epoch = sched == nullptr ? EpochMark::EPOCH_A : Scheduler::epoch();
 
@@ -869,11 +1472,14 @@ namespace verona::rt
         Scheduler::record_inflight_message();
       }
 
-      // Try to acquire as many cowns as possible without rescheduling,
-      // starting from the beginning.
-      fast_send(body, epoch);
+      // The allocations are counted where they are made, in `MultiMessage`.
+      if (sched != nullptr)
+        sched->core->stats.behaviour(count);
+
+      return epoch;
     }
 
+  public:
     /**
      * This processes a batch of messages on a cown.
      *
@@ -896,7 +1502,8 @@ namespace verona::rt
       auto until = queue.peek_back();
       yield(); // Reading global state in peek_back().
 
-      static constexpr size_t batch_limit = 100;
+      const auto batch_limit = next_batch_limit();
+      const auto batch_start = (batch_limit.second) ? Aal::tick() : 0;
       auto notified_called = false;
       auto notify = false;
 
@@ -921,6 +1528,11 @@ namespace verona::rt
           // queue.
           if (!request->is_read() && !read_ref_count.try_write())
             return false;
+
+          // The same if the message waits for the other cowns of a behaviour
+          // this cown runs on its core.
+          if ((pinned_runner(body) == this) && !acquire_pinned(body))
+            return false;
         }
 
         curr = queue.dequeue(alloc, notify);
@@ -959,7 +1571,11 @@ namespace verona::rt
           //      This is designed to be effective if a cown is receiving a lot
           //      of messages.
           if (batch_size != 0)
+          {
+            if (batch_limit.second)
+              record_batch(batch_size, batch_start);
             return true;
+          }
 
           // Reschedule if cown does not go to sleep.
           if (!queue.mark_sleeping(alloc, notify))
@@ -987,6 +1603,7 @@ namespace verona::rt
         assert(!queue.is_sleeping());
 
         batch_size++;
+        Scheduler::local()->core->stats.message();
 
         Logging::cout() << "Running Message " << curr << " on cown " << this
                         << Logging::endl;
@@ -997,11 +1614,44 @@ namespace verona::rt
         if (!run_step(curr))
           return false;
 
-      } while ((curr != until) && (batch_size < batch_limit));
+      } while ((curr != until) && (batch_size < batch_limit.first));
 
+      if (batch_limit.second)
+        record_batch(batch_size, batch_start);
       return true;
     }
 
+    /**
+     * Returns the number of messages to handle in this run of the cown, and
+     * whether it is being adapted to the time the messages take.
+     *
+     * The backlog that a run handles is also bounded by the messages in the
+     * queue when the run starts.
+     **/
+    std::pair<size_t, bool> next_batch_limit()
+    {
+      auto cycles = Scheduler::get_batch_cycles();
+      if (cycles == 0)
+        return {Scheduler::get_batch_limit(), false};
+
+      auto limit = cycles / (message_cycles + 1);
+      return {std::clamp<uint64_t>(limit, 1, Scheduler::get_batch_limit()),
+              true};
+    }
+
+    /**
+     * Update the average time this cown takes to handle a message, from a
+     * batch of `batch_size` messages that started at `start`.
+     *
+     * Must only be called while this thread still runs the cown, so not once
+     * it has been handed to a multi-message, or released.
+     **/
+    void record_batch(size_t batch_size, uint64_t start)
+    {
+      auto sample = (Aal::tick() - start) / batch_size;
+      message_cycles = (message_cycles * 7 + sample) / 8;
+    }
+
     bool try_collect(Alloc& alloc, EpochMark epoch)
     {
       Logging::cout() << "try_collect: " << this << " (" << get_epoch_mark()
@@ -1083,6 +1733,10 @@ namespace verona::rt
 
       mark_collected();
 
+      // The core it is pinned to may now be retired.
+      if (is_pinned())
+        owning_core()->pinned_cowns--;
+
 #ifdef USE_SYSTEMATIC_TESTING_WEAK_NOTICEBOARDS
       flush_all(alloc);
 #endif
@@ -1132,7 +1786,7 @@ namespace verona::rt
       // All messages must have been run by the time the cown is collected.
       assert(stub->next.load(std::memory_order_relaxed) == nullptr);
 
-      alloc.dealloc<sizeof(MultiMessage)>(stub);
+      stub->dealloc(alloc);
     }
 
     bool release_early()
@@ -1156,7 +1810,7 @@ namespace verona::rt
 
         if (
           !senders[s].is_read() ||
-          senders[s].cown()->read_ref_count.release_read())
+          senders[s].cown()->read_ref_count.release_read(reader_slot()))
         {
           senders[s].cown()->schedule();
         }
@@ -0,0 +1,17 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+namespace verona::rt
+{
+  /**
+   * How close two cores are, from nearest to furthest: sharing a core complex
+   * (the last level cache), sharing a NUMA node, or neither.
+   */
+  enum class Locality
+  {
+    Complex,
+    Node,
+    Remote,
+  };
+} // namespace verona::rt
@@ -0,0 +1,252 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include "schedulerstats.h"
+
+#include <snmalloc/snmalloc.h>
+
+namespace verona::rt
+{
+  using namespace snmalloc;
+
+  /**
+   * Free lists for the runtime's short-lived allocations: the body of each
+   * behaviour, and its message to each cown, see `MultiMessage`.
+   *
+   * A behaviour's body and messages are allocated on the thread that
+   * schedules it, and are freed on the thread that runs it, which is often
+   * another one.  Each scheduler thread has a pool, which keeps the blocks
+   * freed on that thread in a free list per size class, and reuses them for
+   * its next allocations.  In a steady state, sending a behaviour then does
+   * not call into the allocator.
+   *
+   * All of the blocks in a class have the same size, so a block freed on one
+   * thread can be reused by any other, and is not returned to the thread that
+   * allocated it.  When a list grows past `LIST_LIMIT`, half of it is returned
+   * to the allocator at once, which batches the return of any blocks owned by
+   * other threads.
+   *
+   * The classes for bodies are whole cache lines, and the allocator aligns a
+   * block to its size, so a body, its requests and its behaviour start on a
+   * cache line and share as few lines as they can.  Larger bodies are not
+   * pooled.
+   *
+   * Threads that are not scheduler threads do not have a pool, and use the
+   * allocator directly.
+   */
+  class MessagePool
+  {
+  public:
+    static constexpr size_t CACHE_LINE_SIZE = SchedulerStats::CACHE_LINE_SIZE;
+
+    /// The largest pooled body, in cache lines.
+    static constexpr size_t BODY_LINES = 4;
+
+    /// The size of a message.
+    static constexpr size_t MESSAGE_SIZE = 2 * sizeof(void*);
+
+    /// The most blocks kept in one class, see `dealloc_block`.
+    static constexpr size_t LIST_LIMIT = 256;
+
+  private:
+    // Class 0 holds messages, and class `n` bodies of `n` cache lines.
+    static constexpr size_t CLASSES = 1 + BODY_LINES;
+
+    struct FreeBlock
+    {
+      FreeBlock* next;
+    };
+
+    struct FreeList
+    {
+      FreeBlock* head = nullptr;
+      size_t length = 0;
+    };
+
+    FreeList lists[CLASSES];
+
+    // Where blocks taken from the allocator and reused blocks are counted,
+    // see `SchedulerStats::alloc` and `SchedulerStats::pooled`.
+    SchedulerStats* stats = nullptr;
+
+    static MessagePool*& local()
+    {
+      static thread_local MessagePool* local;
+      return local;
+    }
+
+    /**
+     * The class of a body of `size` bytes, or `CLASSES` if it is not pooled.
+     */
+    static size_t body_class(size_t size)
+    {
+      if (size > BODY_LINES * CACHE_LINE_SIZE)
+        return CLASSES;
+
+      return bits::align_up(size, CACHE_LINE_SIZE) / CACHE_LINE_SIZE;
+    }
+
+    void* alloc_block(Alloc& alloc, size_t index, size_t size)
+    {
+      auto& list = lists[index];
+      if (list.head == nullptr)
+      {
+        stats->alloc();
+        return alloc.alloc(size);
+      }
+
+      auto* b = list.head;
+      list.head = b->next;
+      list.length--;
+      stats->pooled();
+      return b;
+    }
+
+    void dealloc_block(Alloc& alloc, void* p, size_t index, size_t size)
+    {
+      auto& list = lists[index];
+      list.head = new (p) FreeBlock{list.head};
+      if (++list.length > LIST_LIMIT)
+        trim(alloc, index, size);
+    }
+
+    /**
+     * Return the oldest half of the list with `index` to the allocator.
+     */
+    void trim(Alloc& alloc, size_t index, size_t size)
+    {
+      auto& list = lists[index];
+      auto keep = list.length / 2;
+
+      FreeBlock* last = list.head;
+      for (size_t i = 1; i < keep; i++)
+        last = last->next;
+
+      FreeBlock* b = last->next;
+      last->next = nullptr;
+      list.length = keep;
+
+      while (b != nullptr)
+      {
+        auto next = b->next;
+        alloc.dealloc(b, size);
+        b = next;
+      }
+    }
+
+  public:
+    MessagePool() = default;
+    MessagePool(const MessagePool&) = delete;
+    MessagePool& operator=(const MessagePool&) = delete;
+
+    ~MessagePool()
+    {
+      for (auto& list : lists)
+      {
+        UNUSED(list);
+        assert(list.head == nullptr);
+      }
+    }
+
+    /**
+     * Make this the calling thread's pool, counting the blocks it reuses in
+     * `stats`.
+     */
+    void attach(SchedulerStats* stats)
+    {
+      this->stats = stats;
+      local() = this;
+    }
+
+    /**
+     * Return every block to the allocator, and detach this pool from the
+     * calling thread.  The pool must be flushed before its thread stops
+     * running behaviours, so that no blocks are held when the runtime is torn
+     * down.
+     */
+    void flush(Alloc& alloc)
+    {
+      for (size_t i = 0; i < CLASSES; i++)
+      {
+        auto& list = lists[i];
+        while (list.head != nullptr)
+        {
+          auto next = list.head->next;
+          alloc.dealloc(list.head);
+          list.head = next;
+        }
+        list.length = 0;
+      }
+
+      if (local() == this)
+        local() = nullptr;
+    }
+
+    static void* alloc_message(Alloc& alloc)
+    {
+      auto* pool = local();
+      if (pool == nullptr)
+        return alloc.alloc<MESSAGE_SIZE>();
+
+      return pool->alloc_block(alloc, 0, MESSAGE_SIZE);
+    }
+
+    static void dealloc_message(Alloc& alloc, void* p)
+    {
+      auto* pool = local();
+      if (pool == nullptr)
+      {
+        alloc.dealloc<MESSAGE_SIZE>(p);
+        return;
+      }
+
+      pool->dealloc_block(alloc, p, 0, MESSAGE_SIZE);
+    }
+
+    /**
+     * Allocate a block for a body of `size` bytes, which is rounded up to
+     * whole cache lines if it is pooled.
+     */
+    static void* alloc_body(Alloc& alloc, size_t size)
+    {
+      auto* pool = local();
+      auto index = body_class(size);
+      if (index == CLASSES)
+      {
+        if (pool != nullptr)
+          pool->stats->alloc();
+        return alloc.alloc(size);
+      }
+
+      auto block_size = index * CACHE_LINE_SIZE;
+      if (pool == nullptr)
+        return alloc.alloc(block_size);
+
+      return pool->alloc_block(alloc, index, block_size);
+    }
+
+    /**
+     * Free a block allocated by `alloc_body` with the same `size`.
+     */
+    static void dealloc_body(Alloc& alloc, void* p, size_t size)
+    {
+      auto* pool = local();
+      auto index = body_class(size);
+      if (index == CLASSES)
+      {
+        alloc.dealloc(p, size);
+        return;
+      }
+
+      auto block_size = index * CACHE_LINE_SIZE;
+      if (pool == nullptr)
+      {
+        alloc.dealloc(p, block_size);
+        return;
+      }
+
+      pool->dealloc_block(alloc, p, index, block_size);
+    }
+  };
+} // namespace verona::rt
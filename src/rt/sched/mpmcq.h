@@ -90,8 +90,21 @@ namespace verona::rt
      * completed.
      */
     void enqueue(Alloc& alloc, T* node)
+    {
+      enqueue_batch(alloc, &node, 1);
+    }
+
+    /**
+     * Enqueue `count` nodes, in order, with a single exchange on `back`.
+     * This is not linearisable with respect to dequeue, see `enqueue`.
+     */
+    void enqueue_batch(Alloc& alloc, T** nodes, size_t count)
     {
       UNUSED(alloc);
+      assert(count > 0);
+      for (size_t i = 0; i < count - 1; i++)
+        unmask(nodes[i])->next_in_queue = nodes[i + 1];
+      T* node = nodes[count - 1];
       auto unmasked_node = unmask(node);
       unmasked_node->next_in_queue = nullptr;
       std::atomic_thread_fence(std::memory_order_release);
@@ -101,7 +114,7 @@ namespace verona::rt
       // before exchanging into the structure, as the element cannot be removed
       // if it has a null next pointer, we know the write is safe.
       assert(unmasked_back->next_in_queue == nullptr);
-      unmasked_back->next_in_queue.store(node, std::memory_order_relaxed);
+      unmasked_back->next_in_queue.store(nodes[0], std::memory_order_relaxed);
     }
 
     void enqueue_front(Alloc& alloc, T* node)
@@ -158,6 +171,64 @@ namespace verona::rt
       return fnt;
     }
 
+    /**
+     * Take up to `max` elements from the front of the queue with a single
+     * update of `front`, writing them to `out` in order.  Returns how many
+     * were taken.  A token is only taken on its own, so the batch stops
+     * before one.
+     *
+     * This may spuriously fail, as `dequeue` can.
+     */
+    size_t dequeue_batch(Alloc& alloc, T** out, size_t max)
+    {
+      T* next;
+      T* fnt;
+      size_t count;
+
+      // Hold epoch to ensure that the elements read from the front cannot be
+      // deallocated during this operation, see `dequeue`.
+      Epoch e(alloc);
+      uint64_t epoch = e.get_local_epoch_epoch();
+
+      auto cmp = front.read();
+      do
+      {
+        fnt = cmp.ptr();
+        next = unmask(fnt)->next_in_queue;
+
+        // As in `dequeue`, the last element in the queue cannot be taken.
+        if (next == nullptr)
+          return 0;
+
+        // Extend the batch while the element after it is in the queue.  If
+        // `front` has moved on, these links may be stale, but then the
+        // `store_conditional` will fail.
+        for (count = 1;
+             (count < max) && !is_bit_set(fnt) && !is_bit_set(next);
+             count++)
+        {
+          T* after = next->next_in_queue;
+          if (after == nullptr)
+            break;
+
+          next = after;
+        }
+      } while (!cmp.store_conditional(next));
+
+      // Read all of the links before recording the epoch, which shares their
+      // storage.
+      out[0] = fnt;
+      for (size_t i = 1; i < count; i++)
+        out[i] = unmask(out[i - 1])->next_in_queue;
+
+      assert(epoch != T::NO_EPOCH_SET);
+
+      for (size_t i = 0; i < count; i++)
+        unmask(out[i])->epoch_when_popped = epoch;
+
+      return count;
+    }
+
     // The callers are expected to guarantee no one is attempting to access the
     // queue concurrently.
     void destroy(Alloc& alloc)
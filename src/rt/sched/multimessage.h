@@ -5,6 +5,7 @@
 #include "../ds/mpscq.h"
 #include "../object/object.h"
 #include "behaviour.h"
+#include "messagepool.h"
 
 #include <snmalloc/snmalloc.h>
 
@@ -21,17 +22,44 @@ namespace verona::rt
      * `count` cown pointers, and then the behaviour's body.
      *
      * This layout allows the message body to be single allocation even though
-     * there are multiple different sized pieces.
+     * there are multiple different sized pieces.  It is allocated from the
+     * `MessagePool`, so that it starts on a cache line.
      */
     struct Body
     {
       std::atomic<size_t> exec_count_down;
       size_t count;
 
+      // When the behaviour was scheduled, and when its first cown was
+      // acquired, if `BehaviourLatency` was enabled when it was scheduled.
+      // The first cown is usually acquired on a different thread from the
+      // last, which reads `acquired_tick`.
+      uint64_t sent_tick = 0;
+      std::atomic<uint64_t> acquired_tick{0};
+
     private:
       Body(size_t count) : exec_count_down(count), count(count) {}
 
     public:
+      /**
+       * Called when one of the cowns has been acquired.  Returns the number of
+       * cowns that were still to be acquired, including this one.
+       */
+      size_t acquire_one()
+      {
+        // Set before the decrement, so that the last acquirer, which
+        // decrements after every other, sees it.
+        if (
+          (sent_tick != 0) &&
+          (acquired_tick.load(std::memory_order_relaxed) == 0))
+        {
+          uint64_t none = 0;
+          acquired_tick.compare_exchange_strong(
+            none, Aal::tick(), std::memory_order_relaxed);
+        }
+        return exec_count_down.fetch_sub(1);
+      }
+
       /**
        * TODO When we move to C++20, convert to returning a span.
        */
@@ -46,6 +74,16 @@ namespace verona::rt
           this, sizeof(Body) + sizeof(Request) * count);
       }
 
+      /**
+       * The size of this body, which must be read before its behaviour is
+       * run, as the behaviour finalises itself.
+       */
+      size_t size()
+      {
+        return sizeof(Body) + (sizeof(Request) * count) +
+          get_behaviour().get_descriptor()->size;
+      }
+
       /**
        * Allocates a message body with sufficient space for the
        * cowns_array and the behaviour.  This does not initialise the cowns
@@ -57,7 +95,7 @@ namespace verona::rt
         size_t size = sizeof(Body) + (sizeof(Request) * count) + sizeof(Be);
 
         // Create behaviour
-        auto body = new (alloc.alloc(size)) Body(count);
+        auto body = new (MessagePool::alloc_body(alloc, size)) Body(count);
         new ((Be*)&(body->get_behaviour())) Be(std::forward<Args>(args)...);
 
         static_assert(
@@ -67,6 +105,14 @@ namespace verona::rt
 
         return body;
       }
+
+      /**
+       * Deallocates a message body of `size` bytes, see `size`.
+       */
+      static void dealloc(Alloc& alloc, Body* body, size_t size)
+      {
+        MessagePool::dealloc_body(alloc, body, size);
+      }
     };
 
   private:
@@ -86,7 +132,7 @@ namespace verona::rt
 
     static MultiMessage* make(Alloc& alloc, EpochMark epoch, Body* body)
     {
-      auto msg = (MultiMessage*)alloc.alloc<sizeof(MultiMessage)>();
+      auto msg = (MultiMessage*)MessagePool::alloc_message(alloc);
       msg->body = body;
       msg->set_epoch(epoch);
       return msg;
@@ -124,9 +170,11 @@ namespace verona::rt
       return m;
     }
 
-    inline size_t size()
+    void dealloc(Alloc& alloc)
     {
-      return sizeof(MultiMessage);
+      MessagePool::dealloc_message(alloc, this);
     }
   };
+
+  static_assert(sizeof(MultiMessage) == MessagePool::MESSAGE_SIZE);
 } // namespace verona::rt
@@ -0,0 +1,22 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace verona::rt
+{
+  /**
+   * The scheduling priority of a cown, see `Cown::set_priority`.  Each core
+   * has a queue per level, and takes cowns from the highest level first, see
+   * `Core::dequeue`.
+   */
+  enum class Priority : uint8_t
+  {
+    Normal,
+    High,
+  };
+
+  static constexpr size_t PRIORITY_LEVELS = 2;
+} // namespace verona::rt
@@ -2,89 +2,379 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 
+#include "locality.h"
+
+#include <atomic>
 #include <iostream>
 #include <snmalloc/snmalloc.h>
 
 namespace verona::rt
 {
   using namespace snmalloc;
+
+  /**
+   * Counters for the work done by the scheduler threads on one core.
+   *
+   * The counters are always kept, and can be read while the runtime is
+   * running with `ThreadPool::snapshot_stats`.  Each core has its own
+   * counters, on their own cache lines.  The counters on the first cache line
+   * are only updated by the threads servicing the core, so are updated with
+   * relaxed loads and stores rather than atomic increments.  If the system
+   * monitor has added a thread to the core they may undercount.  The counters
+   * on the second cache line are also updated by other threads, and use atomic
+   * increments.
+   *
+   * Building with `USE_SCHED_STATS` prints the totals when the process exits.
+   */
   class SchedulerStats
   {
+  public:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    /**
+     * Totals of the counters over some cores, see `ThreadPool::snapshot_stats`.
+     */
+    struct Snapshot
+    {
+      uint64_t behaviours_scheduled = 0;
+      uint64_t messages_enqueued = 0;
+      uint64_t allocs = 0;
+      uint64_t pooled_allocs = 0;
+      uint64_t behaviours_run = 0;
+      uint64_t inline_runs = 0;
+      uint64_t batches = 0;
+      uint64_t batched_messages = 0;
+      uint64_t cross_core_schedules = 0;
+      uint64_t steal_attempts = 0;
+      uint64_t steals = 0;
+      uint64_t steals_complex = 0;
+      uint64_t steals_node = 0;
+      uint64_t steals_remote = 0;
+      uint64_t steals_batched = 0;
+      uint64_t pauses = 0;
+      uint64_t paused_cycles = 0;
+      uint64_t unpauses = 0;
+      uint64_t lifo_schedules = 0;
+      uint64_t pinned_schedules = 0;
+      uint64_t cowns_enqueued = 0;
+      uint64_t cowns_dequeued = 0;
+      uint64_t cowns_adopted = 0;
+
+      /**
+       * The number of cowns waiting in the scheduler queues.  This is
+       * approximate, as the counters are not read atomically together.
+       */
+      uint64_t queue_depth() const
+      {
+        if (cowns_dequeued > cowns_enqueued)
+          return 0;
+
+        return cowns_enqueued - cowns_dequeued;
+      }
+
+      /**
+       * The average number of messages a cown handled each time it was run.
+       */
+      uint64_t mean_batch_size() const
+      {
+        if (batches == 0)
+          return 0;
+
+        return batched_messages / batches;
+      }
+    };
+
   private:
-#ifdef USE_SCHED_STATS
-    size_t steal_count = 0;
-    size_t pause_count = 0;
-    std::atomic<size_t> unpause_count = 0;
-    std::atomic<size_t> lifo_count = 0;
-#endif
+    /**
+     * A counter with a single writer, that any thread can read.
+     */
+    class Counter
+    {
+      std::atomic<uint64_t> value{0};
+
+    public:
+      void add(uint64_t n = 1)
+      {
+        value.store(
+          value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      }
+
+      uint64_t get() const
+      {
+        return value.load(std::memory_order_relaxed);
+      }
+    };
+
+    // Updated by the threads servicing this core.
+    alignas(CACHE_LINE_SIZE) Counter behaviour_count;
+    Counter message_count;
+    Counter alloc_count;
+    Counter pooled_count;
+    Counter run_count;
+    Counter inline_count;
+    Counter batch_count;
+    Counter batched_message_count;
+    Counter cross_core_count;
+    Counter steal_attempt_count;
+    Counter steal_complex_count;
+    Counter steal_node_count;
+    Counter steal_remote_count;
+    Counter steal_batched_count;
+    Counter pause_count;
+    Counter paused_cycles;
+    Counter enqueue_count;
+    Counter dequeue_count;
+
+    // Updated by any thread.
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> unpause_count{0};
+    std::atomic<uint64_t> lifo_count{0};
+    std::atomic<uint64_t> pinned_count{0};
+    std::atomic<uint64_t> stolen_count{0};
+    std::atomic<uint64_t> adopted_count{0};
 
   public:
     ~SchedulerStats()
 #ifdef USE_SCHED_STATS
     {
       static snmalloc::FlagWord lock;
-      static SchedulerStats global;
-
-      if (this != &global)
+      static Snapshot global;
+      static struct Printer
       {
-        FlagLock f(lock);
-        global.add(*this);
-      }
-      else
-      {
-        print(std::cout);
-      }
+        ~Printer()
+        {
+          print(std::cout, global);
+        }
+      } printer;
+
+      FlagLock f(lock);
+      snapshot(global);
     }
 #else
       = default;
 #endif
 
-    void steal()
+    /**
+     * Record an attempt to steal a cown from another core.
+     */
+    void steal_attempt()
     {
-#ifdef USE_SCHED_STATS
-      steal_count++;
-#endif
+      steal_attempt_count.add();
     }
 
-    void pause()
+    /**
+     * Record a cown stolen from a core at the given distance from this one.
+     */
+    void steal(Locality locality)
     {
-#ifdef USE_SCHED_STATS
-      pause_count++;
-#endif
+      switch (locality)
+      {
+        case Locality::Complex:
+          steal_complex_count.add();
+          break;
+        case Locality::Node:
+          steal_node_count.add();
+          break;
+        case Locality::Remote:
+          steal_remote_count.add();
+          break;
+      }
+    }
+
+    /**
+     * Record `cowns` moved onto this core's queue along with a stolen cown,
+     * see `ThreadPool::set_steal_batch`.
+     */
+    void steal_batch(size_t cowns)
+    {
+      steal_batched_count.add(cowns);
+      enqueue_count.add(cowns);
+    }
+
+    /**
+     * Record a pause of the scheduler thread that lasted `cycles`.
+     */
+    void pause(uint64_t cycles)
+    {
+      pause_count.add();
+      paused_cycles.add(cycles);
+    }
+
+    /**
+     * The total cycles the scheduler threads of this core have been paused.
+     */
+    uint64_t paused() const
+    {
+      return paused_cycles.get();
     }
 
     void unpause()
     {
-#ifdef USE_SCHED_STATS
-      unpause_count++;
-#endif
+      unpause_count.fetch_add(1, std::memory_order_relaxed);
     }
 
+    /**
+     * Record a cown scheduled at the front of this core's queue, from any
+     * thread.
+     */
     void lifo()
     {
-#ifdef USE_SCHED_STATS
-      lifo_count++;
-#endif
+      lifo_count.fetch_add(1, std::memory_order_relaxed);
     }
 
-    void add(SchedulerStats& that)
+    /**
+     * Record a cown pinned to this core scheduled, or returned after being
+     * stolen, by another thread.
+     */
+    void pinned()
     {
-      UNUSED(that);
+      pinned_count.fetch_add(1, std::memory_order_relaxed);
+    }
 
-#ifdef USE_SCHED_STATS
-      steal_count += that.steal_count;
-      pause_count += that.pause_count;
-      unpause_count += that.unpause_count;
-      lifo_count += that.lifo_count;
-#endif
+    /**
+     * Record a cown scheduled at the back of this core's queue.  `cross_core`
+     * is true if the cown was last run on another core.
+     */
+    void enqueue(bool cross_core)
+    {
+      enqueue_count.add();
+      if (cross_core)
+        cross_core_count.add();
     }
 
-    void print(std::ostream& o, uint64_t dumpid = 0)
+    /**
+     * Record a cown taken from this core's queue by its own threads.
+     */
+    void dequeue()
     {
-      UNUSED(o);
-      UNUSED(dumpid);
+      dequeue_count.add();
+    }
 
-#ifdef USE_SCHED_STATS
+    /**
+     * Record cowns taken from this core's queue by another core.
+     */
+    void stolen(size_t cowns = 1)
+    {
+      stolen_count.fetch_add(cowns, std::memory_order_relaxed);
+    }
+
+    /**
+     * Record `cowns` moved onto this core's queue from a core that is
+     * retiring, see `ThreadPool::set_active_cores`.
+     */
+    void adopt(size_t cowns)
+    {
+      adopted_count.fetch_add(cowns, std::memory_order_relaxed);
+    }
+
+    /**
+     * The number of cowns waiting in this core's queue.  This is approximate,
+     * see `Snapshot::queue_depth`.
+     */
+    uint64_t queue_depth() const
+    {
+      auto enqueued = enqueue_count.get() +
+        lifo_count.load(std::memory_order_relaxed) +
+        pinned_count.load(std::memory_order_relaxed) +
+        adopted_count.load(std::memory_order_relaxed);
+      auto dequeued =
+        dequeue_count.get() + stolen_count.load(std::memory_order_relaxed);
+      return (enqueued > dequeued) ? enqueued - dequeued : 0;
+    }
+
+    /**
+     * Record a cown being run, see `message` for the messages it handles.
+     */
+    void batch()
+    {
+      batch_count.add();
+    }
+
+    /**
+     * Record a message handled by a cown.
+     */
+    void message()
+    {
+      batched_message_count.add();
+    }
+
+    /**
+     * Record a block that this core's `MessagePool` took from the allocator,
+     * for the body of a behaviour or a promise, or a message to a cown.
+     */
+    void alloc()
+    {
+      alloc_count.add();
+    }
+
+    /**
+     * Record a block that this core's `MessagePool` reused instead of taking
+     * it from the allocator, see `alloc`.
+     */
+    void pooled()
+    {
+      pooled_count.add();
+    }
+
+    /**
+     * Record a behaviour run on this core.
+     */
+    void run()
+    {
+      run_count.add();
+    }
+
+    void run_inline()
+    {
+      inline_count.add();
+    }
+
+    /**
+     * Record a behaviour scheduled from this core on `cowns` cowns.
+     */
+    void behaviour(size_t cowns)
+    {
+      behaviour_count.add();
+      message_count.add(cowns);
+    }
+
+    /**
+     * Add the current values of these counters to `s`.  This can be called
+     * from any thread, while the counters are being updated.
+     */
+    void snapshot(Snapshot& s) const
+    {
+      s.behaviours_scheduled += behaviour_count.get();
+      s.messages_enqueued += message_count.get();
+      s.allocs += alloc_count.get();
+      s.pooled_allocs += pooled_count.get();
+      s.behaviours_run += run_count.get();
+      s.inline_runs += inline_count.get();
+      s.batches += batch_count.get();
+      s.batched_messages += batched_message_count.get();
+      s.cross_core_schedules += cross_core_count.get();
+      s.steal_attempts += steal_attempt_count.get();
+      s.steals_complex += steal_complex_count.get();
+      s.steals_node += steal_node_count.get();
+      s.steals_remote += steal_remote_count.get();
+      s.steals_batched += steal_batched_count.get();
+      s.steals += steal_complex_count.get() + steal_node_count.get() +
+        steal_remote_count.get();
+      s.pauses += pause_count.get();
+      s.paused_cycles += paused_cycles.get();
+      auto lifos = lifo_count.load(std::memory_order_relaxed);
+      auto pinned = pinned_count.load(std::memory_order_relaxed);
+      auto adopted = adopted_count.load(std::memory_order_relaxed);
+      s.unpauses += unpause_count.load(std::memory_order_relaxed);
+      s.lifo_schedules += lifos;
+      s.pinned_schedules += pinned;
+      s.cowns_adopted += adopted;
+      s.cowns_enqueued += enqueue_count.get() + lifos + pinned + adopted;
+      s.cowns_dequeued +=
+        dequeue_count.get() + stolen_count.load(std::memory_order_relaxed);
+    }
+
+    static void print(std::ostream& o, const Snapshot& s, uint64_t dumpid = 0)
+    {
       CSVStream csv(&o);
 
       if (dumpid == 0)
@@ -96,12 +386,34 @@ namespace verona::rt
             << "Steal"
             << "LIFO"
             << "Pause"
-            << "Unpause" << csv.endl;
+            << "Unpause"
+            << "Behaviours"
+            << "Allocs"
+            << "Inline"
+            << "StealComplex"
+            << "StealNode"
+            << "StealRemote"
+            << "StealAttempts"
+            << "Messages"
+            << "Run"
+            << "CrossCore"
+            << "PausedCycles"
+            << "MeanBatch"
+            << "QueueDepth"
+            << "Pinned"
+            << "StealBatched"
+            << "Adopted"
+            << "Pooled" << csv.endl;
       }
 
-      csv << "SchedulerStats" << dumpid << steal_count << lifo_count
-          << pause_count << unpause_count << csv.endl;
-#endif
+      csv << "SchedulerStats" << dumpid << s.steals << s.lifo_schedules
+          << s.pauses << s.unpauses << s.behaviours_scheduled << s.allocs
+          << s.inline_runs << s.steals_complex << s.steals_node
+          << s.steals_remote << s.steal_attempts << s.messages_enqueued
+          << s.behaviours_run << s.cross_core_schedules << s.paused_cycles
+          << s.mean_batch_size() << s.queue_depth() << s.pinned_schedules
+          << s.steals_batched << s.cowns_adopted << s.pooled_allocs
+          << csv.endl;
     }
   };
 } // namespace verona::rt
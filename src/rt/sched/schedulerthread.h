@@ -6,6 +6,7 @@
 #include "ds/dllist.h"
 #include "ds/hashmap.h"
 #include "ds/mpscq.h"
+#include "messagepool.h"
 #include "mpmcq.h"
 #include "object/object.h"
 #include "schedulerlist.h"
@@ -46,7 +47,9 @@ namespace verona::rt
     template<typename Owner>
     friend class Noticeboard;
 
-    static constexpr uint64_t TSC_QUIESCENCE_TIMEOUT = 1'000'000;
+    // How long to look for work on this NUMA node before stealing from other
+    // nodes, see `widen_reach`.
+    static constexpr uint64_t TSC_REMOTE_STEAL_BACKOFF = 100'000;
 
     Core<T>* core = nullptr;
 #ifdef USE_SYSTEMATIC_TESTING
@@ -60,14 +63,30 @@ namespace verona::rt
     Alloc* alloc = nullptr;
     Core<T>* victim = nullptr;
 
+    /// Free lists for the messages this thread sends.
+    MessagePool pool;
+
     bool running = true;
 
+    /// Set once this thread has retired, see `finish_retire`.
+    bool retired = false;
+
+    /// When this thread last measured the utilisation of its core, and the
+    /// paused cycles at that point, see `check_elastic`.
+    uint64_t elastic_start = 0;
+    uint64_t elastic_paused = 0;
+
     // `n_ld_tokens` indicates the times of token cown a scheduler has to
     // process before reaching its LD checkpoint (`n_ld_tokens == 0`).
     uint8_t n_ld_tokens = 0;
 
     bool should_steal_for_fairness = false;
 
+    /// When this thread last stole for fairness, and the next core to
+    /// compare queue depths with, see `check_rebalance`.
+    uint64_t last_rebalance = 0;
+    Core<T>* rebalance_victim = nullptr;
+
     std::atomic<bool> scheduled_unscanned_cown = false;
 
     EpochMark send_epoch = EpochMark::EPOCH_A;
@@ -78,6 +97,12 @@ namespace verona::rt
     /// The MessageBody of a running behaviour.
     typename T::MessageBody* message_body = nullptr;
 
+    /// Nesting depth of behaviours run inline by this thread.
+    size_t inline_depth = 0;
+
+    /// Behaviours run inline since this thread last ran a cown from its queue.
+    size_t inline_count = 0;
+
     /// SchedulerList pointers.
     SchedulerThread<T>* prev = nullptr;
     SchedulerThread<T>* next = nullptr;
@@ -118,19 +143,47 @@ namespace verona::rt
         scheduled_unscanned_cown = true;
       }
       assert(!a->queue.is_sleeping());
-      core->q.enqueue(*alloc, a);
+      core->queue(a->get_priority()).enqueue(*alloc, a);
+      core->stats.enqueue(
+        (a->owning_core() != nullptr) && (a->owning_core() != core));
 
       if (Scheduler::get().unpause())
         core->stats.unpause();
     }
 
+    /**
+     * Called by `t`, if it is a scheduler thread, before it puts `cown` on
+     * the queues of `c`, which it may not service.  As in `schedule_fifo`,
+     * the LD protocol must not advance past an unscanned cown that `t` has
+     * scheduled.  The threads of `c` may already have reached their LD
+     * checkpoint, so `c` is marked as well, see
+     * `Core::scheduled_unscanned_cown`.  If `t` has not started scanning, it
+     * cannot tell whether the cown has been scanned, so `c` is marked anyway.
+     */
+    static void check_unscanned(SchedulerThread* t, Core<T>* c, T* cown)
+    {
+      if (t == nullptr)
+        return;
+
+      if (!cown->scanned(t->send_epoch))
+      {
+        Logging::cout() << "Enqueue unscanned cown " << cown << Logging::endl;
+        t->scheduled_unscanned_cown = true;
+        c->scheduled_unscanned_cown = true;
+      }
+      else if (!Scheduler::should_scan())
+      {
+        c->scheduled_unscanned_cown = true;
+      }
+    }
+
     static inline void schedule_lifo(Core<T>* c, T* a)
     {
       // A lifo scheduled cown is coming from an external source, such as
       // asynchronous I/O.
       Logging::cout() << "LIFO scheduling cown " << a << " onto " << c->affinity
                       << Logging::endl;
-      c->q.enqueue_front(ThreadAlloc::get(), a);
+      c->queue(a->get_priority()).enqueue_front(ThreadAlloc::get(), a);
       Logging::cout() << "LIFO scheduled cown " << a << " onto " << c->affinity
                       << Logging::endl;
 
@@ -138,6 +191,42 @@ namespace verona::rt
 
       if (Scheduler::get().unpause())
         c->stats.unpause();
+
+      forward_retired(c);
+    }
+
+    /**
+     * Schedule a pinned cown on its core, from any thread, see `Cown::pin`.
+     */
+    static inline void schedule_pinned(T* a)
+    {
+      Core<T>* c = a->owning_core();
+      Logging::cout() << "Enqueue pinned cown " << a << " onto " << c->affinity
+                      << Logging::endl;
+
+      check_unscanned(Scheduler::local(), c, a);
+      assert(!a->queue.is_sleeping());
+      c->queue(a->get_priority()).enqueue(ThreadAlloc::get(), a);
+      c->stats.pinned();
+
+      if (Scheduler::get().unpause())
+        c->stats.unpause();
+
+      forward_retired(c);
+    }
+
+    /**
+     * Returns true if a behaviour whose cowns have all been acquired by this
+     * thread may be run inline, see `ThreadPool::set_inline_budget`.
+     *
+     * Inline execution is not used during a leak detector cycle, as the
+     * behaviour would bypass the checks made when a cown is dispatched.
+     **/
+    bool can_run_inline()
+    {
+      auto& s = Scheduler::get();
+      return (inline_depth < s.inline_depth) &&
+        (inline_count < s.inline_count) && (state == ThreadState::NotInLD);
     }
 
     template<typename... Args>
@@ -158,9 +247,14 @@ namespace verona::rt
       startup(args...);
 
       Scheduler::local() = this;
+      Logging::ThreadLocalLog::reset_id();
       alloc = &ThreadAlloc::get();
       assert(core != nullptr);
+      pool.attach(&core->stats);
       victim = core->next;
+      rebalance_victim = core;
+      elastic_start = Aal::tick();
+      elastic_paused = core->stats.paused();
       T* cown = nullptr;
       core->servicing_threads++;
 
@@ -178,21 +272,34 @@ namespace verona::rt
         )
           collect_cown_stubs();
 
+        if (cown == nullptr)
+        {
+          check_rebalance();
+          check_resize();
+        }
+
         if (should_steal_for_fairness)
         {
           if (cown == nullptr)
           {
             should_steal_for_fairness = false;
+            last_rebalance = Aal::tick();
             fast_steal(cown);
           }
         }
 
+        if ((cown == nullptr) && core->retired)
+          cown = hand_over();
+
         if (cown == nullptr)
         {
-          cown = core->q.dequeue(*alloc);
+          cown = core->dequeue(*alloc);
           if (cown != nullptr)
+          {
+            record_dequeue(core, cown);
             Logging::cout()
               << "Pop cown " << clear_thread_bit(cown) << Logging::endl;
+          }
         }
 
         if (cown == nullptr)
@@ -243,11 +350,15 @@ namespace verona::rt
           core->progress_counter++;
         core->last_worker = systematic_id;
 
+        inline_count = 0;
+        core->stats.batch();
+
         bool reschedule = cown->run(*alloc, state);
 
         if (reschedule)
         {
-          if (should_steal_for_fairness)
+          // A retiring thread hands its cowns over, so puts this one back.
+          if (should_steal_for_fairness || core->retired)
           {
             schedule_fifo(cown);
             cown = nullptr;
@@ -259,16 +370,17 @@ namespace verona::rt
             // otherwise run this cown again. Don't push to the queue
             // immediately to avoid another thread stealing our only cown.
 
-            T* n = core->q.dequeue(*alloc);
+            T* n = core->dequeue(*alloc);
 
             if (n != nullptr)
             {
+              record_dequeue(core, n);
               schedule_fifo(cown);
               cown = n;
             }
             else
             {
-              if (core->q.nothing_old())
+              if (core->nothing_old())
               {
                 Logging::cout() << "Queue empty" << Logging::endl;
                 // We have effectively reached token cown.
@@ -300,6 +412,19 @@ namespace verona::rt
         yield();
       }
 
+      if (retired)
+      {
+        Logging::cout() << "Retired from core " << core->affinity
+                        << Logging::endl;
+        Epoch(ThreadAlloc::get()).flush_local();
+        pool.flush(*alloc);
+        Scheduler::get().threads.move_active_to_free(this);
+        Systematic::finished_thread();
+        Scheduler::local() = nullptr;
+        Logging::ThreadLocalLog::reset_id();
+        return;
+      }
+
       Logging::cout() << "Begin teardown (phase 1)" << Logging::endl;
 
       if (core != nullptr)
@@ -322,34 +447,463 @@ namespace verona::rt
 
       if (core != nullptr)
       {
+        // The queues of a retired core are destroyed at the end of `run`.
         auto val = core->servicing_threads.fetch_sub(1);
-        if (val == 1)
+        if ((val == 1) && !core->retired)
         {
           Logging::cout() << "Destroying core " << core->affinity
                           << Logging::endl;
-          core->q.destroy(*alloc);
+          core->destroy_queues(*alloc);
         }
       }
+      pool.flush(*alloc);
       Systematic::finished_thread();
 
       // Reset the local thread pointer as this physical thread could be reused
       // for a different SchedulerThread later.
       Scheduler::local() = nullptr;
+      Logging::ThreadLocalLog::reset_id();
+    }
+
+    /**
+     * Count a cown taken from the queue of `from`, unless it is a token.
+     */
+    void record_dequeue(Core<T>* from, T* cown)
+    {
+      if (has_thread_bit(cown))
+        return;
+
+      if (from == core)
+        core->stats.dequeue();
+      else
+        from->stats.stolen();
+    }
+
+    /**
+     * Pinned cowns are never stolen.  If `cown`, just taken from another
+     * core's queue, is pinned, this puts it back and returns true.
+     */
+    bool return_pinned(T* cown)
+    {
+      if (has_thread_bit(cown) || !cown->is_pinned())
+        return false;
+
+      Logging::cout() << "Return pinned cown " << cown << Logging::endl;
+      schedule_pinned(cown);
+      return true;
+    }
+
+    /**
+     * How many cowns `steal` takes from `victim`: half of its queue, up to
+     * the limit set by `ThreadPool::set_steal_batch`.
+     */
+    size_t steal_batch_size()
+    {
+      size_t max = Scheduler::get().steal_batch;
+      if (max == 1)
+        return 1;
+
+      size_t half = (size_t)(victim->stats.queue_depth() / 2);
+      return (half < 1) ? 1 : ((half > max) ? max : half);
+    }
+
+    /**
+     * Takes ownership of the `count` cowns in `cowns`, just taken from the
+     * queue of `victim`.  Pinned cowns are returned, see `return_pinned`.
+     * Returns the first of the others, or nullptr if there are none, and
+     * moves the rest onto this core's queue with a single enqueue.
+     */
+    T* take_stolen(T** cowns, size_t count)
+    {
+      size_t taken = 0;
+      size_t kept = 0;
+
+      for (size_t i = 0; i < count; i++)
+      {
+        T* cown = cowns[i];
+        if (!has_thread_bit(cown))
+          taken++;
+
+        if (return_pinned(cown))
+          continue;
+
+        // As in `schedule_fifo`.
+        if ((kept != 0) && !cown->scanned(send_epoch))
+        {
+          Logging::cout() << "Enqueue unscanned cown " << cown
+                          << Logging::endl;
+          scheduled_unscanned_cown = true;
+        }
+        cowns[kept++] = cown;
+      }
+
+      if (taken != 0)
+        victim->stats.stolen(taken);
+
+      if (kept == 0)
+        return nullptr;
+
+      if (kept > 1)
+      {
+        Logging::cout() << "Moved " << (kept - 1) << " stolen cowns from "
+                        << victim->affinity << Logging::endl;
+        core->q.enqueue_batch(*alloc, cowns + 1, kept - 1);
+        core->stats.steal_batch(kept - 1);
+
+        if (Scheduler::get().unpause())
+          core->stats.unpause();
+      }
+
+      return cowns[0];
+    }
+
+    /**
+     * Adds a thread, or starts to retire this one, if the number of active
+     * cores differs from `ThreadPool::set_active_cores`, after running the
+     * controller of `ThreadPool::set_elastic`.
+     */
+    void check_resize()
+    {
+      auto& s = Scheduler::get();
+      if (s.elastic_cycles != 0)
+        check_elastic();
+
+      auto target = s.target_cores.load(std::memory_order_relaxed);
+      auto active = Scheduler::get_active_cores();
+      if (
+        (target == active) || core->retired ||
+        (state != ThreadState::NotInLD))
+        return;
+
+      if (target < active)
+        begin_retire();
+      else
+        s.add_core();
+    }
+
+    /**
+     * The controller of `ThreadPool::set_elastic`, which measures the
+     * utilisation of this core once every `cycles`.
+     */
+    void check_elastic()
+    {
+      auto& s = Scheduler::get();
+#ifdef USE_SYSTEMATIC_TESTING
+      // Timing is not reproducible, so would break replaying a seed.
+      if (Systematic::coin(6))
+        s.request_resize(Systematic::coin());
+#else
+      auto now = Aal::tick();
+      auto elapsed = now - elastic_start;
+      if (elapsed < s.elastic_cycles)
+        return;
+
+      auto paused = core->stats.paused();
+      auto idle = paused - elastic_paused;
+      auto utilisation =
+        (idle < elapsed) ? ((elapsed - idle) * 100) / elapsed : 0;
+      elastic_start = now;
+      elastic_paused = paused;
+
+      Logging::cout() << "Core utilisation " << utilisation << "%"
+                      << Logging::endl;
+
+      if (utilisation < Scheduler::ELASTIC_LOW_UTILISATION)
+        s.request_resize(false);
+      else if (
+        (utilisation > Scheduler::ELASTIC_HIGH_UTILISATION) &&
+        !core->nothing_old())
+        s.request_resize(true);
+#endif
+    }
+
+    /**
+     * Returns the next core in the ring after `c` that is not retired.
+     */
+    static Core<T>* next_active_core(Core<T>* c)
+    {
+      c = c->next;
+      while (c->retired)
+        c = c->next;
+      return c;
+    }
+
+    /**
+     * Moves the cowns this core owns to the next active core.  Must be called
+     * holding the thread pool lock, outside of a leak detector cycle, so that
+     * no thread is scanning or sweeping the lists of cowns.
+     */
+    void hand_over_cowns()
+    {
+      T* head = core->drain();
+      if (head == nullptr)
+        return;
+
+      Core<T>* heir = next_active_core(core);
+      T* tail = head;
+      tail->move_to_core(heir);
+      while (tail->next != nullptr)
+      {
+        tail = tail->next;
+        tail->move_to_core(heir);
+      }
+      heir->add_cowns(head, tail);
+      heir->total_cowns += core->total_cowns.exchange(0);
+      heir->free_cowns += core->free_cowns.exchange(0);
+    }
+
+    /**
+     * Starts to retire this thread and its core, if there are still more
+     * active cores than `ThreadPool::set_active_cores` asks for.  The cowns
+     * the core owns are moved to the next active core, and no more work is
+     * sent to it.  Until the thread finishes retiring, see `finish_retire`,
+     * it moves the cowns that reach its queues to the next active core, see
+     * `hand_over`, and takes part in the leak detector as before.  A core
+     * that live cowns are pinned to is not retired.
+     */
+    void begin_retire()
+    {
+      if (core->pinned_cowns != 0)
+        return;
+
+      auto& s = Scheduler::get();
+      auto h = s.sync.handle(this);
+      if (!s.retire_core())
+        return;
+
+      Logging::cout() << "Retiring core " << core->affinity << Logging::endl;
+      core->retired = true;
+      hand_over_cowns();
+    }
+
+    /**
+     * Moves the cowns in this retiring core's queues to the next active core,
+     * until it reaches a token, which is handled as by `prerun`.  Returns a
+     * cown that is still pinned to this core, to run here, if it finds one.
+     */
+    T* hand_over()
+    {
+      Core<T>* heir = next_active_core(core);
+      T* result = nullptr;
+      size_t count = 0;
+
+      while (true)
+      {
+        T* cown = core->dequeue(*alloc);
+        if (cown == nullptr)
+          break;
+
+        record_dequeue(core, cown);
+        if (has_thread_bit(cown))
+        {
+          prerun(cown);
+          break;
+        }
+
+        if (cown->is_pinned() && (cown->owning_core() == core))
+        {
+          result = cown;
+          break;
+        }
+
+        check_unscanned(this, heir, cown);
+        heir->queue(cown->get_priority()).enqueue(*alloc, cown);
+        count++;
+      }
+
+      if (count != 0)
+      {
+        Logging::cout() << "Handed over " << count << " cowns to "
+                        << heir->affinity << Logging::endl;
+        heir->stats.adopt(count);
+
+        if (Scheduler::get().unpause())
+          core->stats.unpause();
+
+        // The heir may have started to retire since it was chosen.
+        forward_retired(heir);
+      }
+
+      return result;
+    }
+
+    /**
+     * Called after enqueuing a cown onto `c` from a thread that may not
+     * service it.  If `c` is retiring, its thread may have finished since
+     * the core was chosen, leaving the cown where no thread will run it or
+     * scan it for the leak detector.  So this thread moves the cowns in the
+     * queues of `c` on, as `hand_over` does, putting back the tokens.
+     */
+    static void forward_retired(Core<T>* c)
+    {
+      // Either this sees `retired`, or `finish_retire` sees the enqueue.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!c->retired)
+        return;
+
+      auto& alloc = ThreadAlloc::get();
+      auto* t = Scheduler::local();
+      Core<T>* heir = next_active_core(c);
+      size_t count = 0;
+
+      while (true)
+      {
+        T* cown = c->dequeue(alloc);
+        if (cown == nullptr)
+          break;
+
+        if (has_thread_bit(cown))
+        {
+          c->q.enqueue(alloc, cown);
+          continue;
+        }
+
+        c->stats.stolen();
+        if (cown->is_pinned())
+        {
+          Core<T>* owner = cown->owning_core();
+          if (owner == c)
+          {
+            // The cowns of `c` are only moved by `finish_retire` before it
+            // checks the queues are empty, so if it still owns this cown
+            // once it is back in its queue, its thread will run it.
+            c->queue(cown->get_priority()).enqueue(alloc, cown);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (cown->owning_core() == c)
+              break;
+            continue;
+          }
+
+          schedule_pinned(cown);
+          continue;
+        }
+
+        check_unscanned(t, heir, cown);
+        heir->queue(cown->get_priority()).enqueue(alloc, cown);
+        count++;
+      }
+
+      if (count != 0)
+      {
+        Logging::cout() << "Forwarded " << count << " cowns from "
+                        << c->affinity << " to " << heir->affinity
+                        << Logging::endl;
+        heir->stats.adopt(count);
+
+        if (Scheduler::get().unpause())
+          heir->stats.unpause();
+
+        forward_retired(heir);
+      }
+    }
+
+    /**
+     * Finishes retiring this thread once its core's queues are empty, and
+     * returns true if it has.  The cowns the core has come to own since
+     * `begin_retire` are moved to the next active core, and the thread stops
+     * being counted by the leak detector and the teardown barrier.  If a cown
+     * has been pinned to the core since `begin_retire`, and not collected,
+     * the core is made active again instead.
+     */
+    bool finish_retire()
+    {
+      auto& s = Scheduler::get();
+      {
+        auto h = s.sync.handle(this);
+        if (!s.can_resize() || (state != ThreadState::NotInLD))
+          return false;
+
+        if (core->pinned_cowns != 0)
+        {
+          Logging::cout() << "Core " << core->affinity
+                          << " has pinned cowns, so stays active"
+                          << Logging::endl;
+          core->retired = false;
+          s.unretire_core();
+          return false;
+        }
+
+        // The cowns are moved before the queues are checked, see
+        // `forward_retired`.
+        hand_over_cowns();
+        if (!core->nothing_old())
+          return false;
+
+        s.thread_count--;
+        s.state.remove_thread();
+        core->servicing_threads--;
+      }
+
+      Logging::cout() << "Retired core " << core->affinity << Logging::endl;
+      retired = true;
+
+      // A paused thread may have been waiting for this one to pause, before
+      // it could begin the teardown.
+      if (s.unpause())
+        core->stats.unpause();
+
+      return true;
+    }
+
+    /**
+     * Decide whether to steal for fairness before the token comes round, see
+     * `ThreadPool::set_rebalance`.
+     */
+    void check_rebalance()
+    {
+      auto& s = Scheduler::get();
+
+      if (s.rebalance_cycles != 0)
+      {
+#ifdef USE_SYSTEMATIC_TESTING
+        // Timing is not reproducible, so would break replaying a seed.
+        if (Systematic::coin(4))
+          should_steal_for_fairness = true;
+#else
+        if ((Aal::tick() - last_rebalance) >= s.rebalance_cycles)
+          should_steal_for_fairness = true;
+#endif
+      }
+
+      if (s.rebalance_depth != 0)
+      {
+        // Look at one other core each time.
+        rebalance_victim = rebalance_victim->next;
+        if (rebalance_victim == core)
+          rebalance_victim = rebalance_victim->next;
+
+        if (
+          (rebalance_victim != core) &&
+          (rebalance_victim->stats.queue_depth() >
+           core->stats.queue_depth() + s.rebalance_depth))
+        {
+          victim = rebalance_victim;
+          should_steal_for_fairness = true;
+        }
+      }
     }
 
     bool fast_steal(T*& result)
     {
-      // auto cur_victim = victim;
       T* cown;
 
-      // Try to steal from the victim thread.
-      if (victim != core)
+      // Try to steal from the victim thread.  Stealing for fairness does not
+      // cross NUMA nodes, that is left to `steal` when this thread runs out of
+      // work.
+      if (
+        (victim != core) && !victim->retired &&
+        (core->locality(victim) != Locality::Remote))
       {
-        cown = victim->q.dequeue(*alloc);
+        core->stats.steal_attempt();
+        cown = victim->dequeue(*alloc);
 
         if (cown != nullptr)
+          record_dequeue(victim, cown);
+
+        if ((cown != nullptr) && !return_pinned(cown))
         {
-          // stats.steal();
+          if (!has_thread_bit(cown))
+            core->stats.steal(core->locality(victim));
           Logging::cout() << "Fast-steal cown " << clear_thread_bit(cown)
                           << " from " << victim->affinity << Logging::endl;
           result = cown;
@@ -370,16 +924,43 @@ namespace verona::rt
       n_ld_tokens--;
     }
 
+    /**
+     * Called after a pass of the core ring at `reach` found nothing to steal.
+     * Widens the search to the rest of the NUMA node straight away, but only
+     * to other nodes once this thread has been looking for work for
+     * `TSC_REMOTE_STEAL_BACKOFF`, as a cown stolen from another node brings
+     * its state across the interconnect.
+     */
+    Locality widen_reach(Locality reach, uint64_t tsc)
+    {
+      if (reach == Locality::Complex)
+        return Locality::Node;
+
+#ifdef USE_SYSTEMATIC_TESTING
+      UNUSED(tsc);
+      if (Systematic::coin())
+        return Locality::Remote;
+#else
+      if ((Aal::tick() - tsc) >= TSC_REMOTE_STEAL_BACKOFF)
+        return Locality::Remote;
+#endif
+
+      return reach;
+    }
+
     T* steal()
     {
       uint64_t tsc = Aal::tick();
       T* cown;
 
+      // Only steal from cores up to this far away, see `widen_reach`.
+      Locality reach = Locality::Complex;
+
       while (running)
       {
         yield();
 
-        if (core->q.nothing_old())
+        if (core->nothing_old())
         {
           n_ld_tokens = 0;
         }
@@ -387,20 +968,42 @@ namespace verona::rt
         // Participate in the cown LD protocol.
         ld_protocol();
 
+        if (core->retired)
+        {
+          if (finish_retire())
+            return nullptr;
+        }
+        else
+        {
+          check_resize();
+        }
+
         // Check if some other thread has pushed work on our queue.
-        cown = core->q.dequeue(*alloc);
+        cown = core->dequeue(*alloc);
 
         if (cown != nullptr)
+        {
+          record_dequeue(core, cown);
           return cown;
+        }
 
-        // Try to steal from the victim thread.
-        if (victim != core)
+        // Try to steal from the victim thread, if it is within reach.  A
+        // retiring thread does not take on more work, and the queues of a
+        // retiring core are left to `hand_over` and `forward_retired`.
+        if (
+          (victim != core) && !core->retired && !victim->retired &&
+          (core->locality(victim) <= reach))
         {
-          cown = victim->q.dequeue(*alloc);
+          core->stats.steal_attempt();
+          T* stolen[Scheduler::MAX_STEAL_BATCH];
+          size_t count =
+            victim->dequeue_batch(*alloc, stolen, steal_batch_size());
+          cown = take_stolen(stolen, count);
 
           if (cown != nullptr)
           {
-            core->stats.steal();
+            if (!has_thread_bit(cown))
+              core->stats.steal(core->locality(victim));
             Logging::cout() << "Stole cown " << clear_thread_bit(cown)
                             << " from " << victim->affinity << Logging::endl;
             return cown;
@@ -409,6 +1012,8 @@ namespace verona::rt
 
         // We were unable to steal, move to the next victim thread.
         victim = victim->next;
+        if (victim == core)
+          reach = widen_reach(reach, tsc);
 
 #ifdef USE_SYSTEMATIC_TESTING
         // Only try to pause with 1/(2^5) probability
@@ -419,34 +1024,37 @@ namespace verona::rt
           continue;
         }
 #else
-        // Wait until a minimum timeout has passed.
+        // Wait until the spin budget has passed, see
+        // `ThreadPool::set_spin_budget`.
         uint64_t tsc2 = Aal::tick();
-        if ((tsc2 - tsc) < TSC_QUIESCENCE_TIMEOUT)
+        if ((tsc2 - tsc) < Scheduler::get().spin_cycles)
         {
           Aal::pause();
           continue;
         }
 #endif
 
-        // Enter sleep only if we aren't executing the leak detector currently.
-        if (state == ThreadState::NotInLD)
+        // Enter sleep only if we aren't executing the leak detector currently,
+        // or retiring.
+        if ((state == ThreadState::NotInLD) && !core->retired)
         {
           // We've been spinning looking for work for some time. While paused,
           // our running flag may be set to false, in which case we terminate.
+          auto pause_start = Aal::tick();
           if (Scheduler::get().pause())
-            core->stats.pause();
+            core->stats.pause(Aal::tick() - pause_start);
         }
       }
 
       return nullptr;
     }
 
-    bool has_thread_bit(T* cown)
+    static bool has_thread_bit(T* cown)
     {
       return (uintptr_t)cown & 1;
     }
 
-    T* clear_thread_bit(T* cown)
+    static T* clear_thread_bit(T* cown)
     {
       return (T*)((uintptr_t)cown & ~(uintptr_t)1);
     }
@@ -543,7 +1151,9 @@ namespace verona::rt
         Logging::cout() << "Scheduler unscanned flag: "
                         << scheduled_unscanned_cown << Logging::endl;
 
-        if (!scheduled_unscanned_cown && Scheduler::no_inflight_messages())
+        if (
+          !scheduled_unscanned_cown && !core->scheduled_unscanned_cown &&
+          Scheduler::no_inflight_messages())
         {
           ld_state_change(ThreadState::BelieveDone_Vote);
         }
@@ -567,7 +1177,7 @@ namespace verona::rt
         // trying to perform a LD.
         if (
           sprev == ThreadState::PreScan && snext == ThreadState::PreScan &&
-          Scheduler::get().unpause())
+          Scheduler::get().unpause_all())
         {
           core->stats.unpause();
         }
@@ -589,7 +1199,7 @@ namespace verona::rt
         {
           case ThreadState::PreScan:
           {
-            if (Scheduler::get().unpause())
+            if (Scheduler::get().unpause_all())
               core->stats.unpause();
 
             enter_prescan();
@@ -613,7 +1223,7 @@ namespace verona::rt
 
           case ThreadState::BelieveDone:
           {
-            if (scheduled_unscanned_cown)
+            if (scheduled_unscanned_cown || core->scheduled_unscanned_cown)
               ld_state_change(ThreadState::BelieveDone_Retract);
             else
               ld_state_change(ThreadState::BelieveDone_Confirm);
@@ -676,6 +1286,7 @@ namespace verona::rt
       core->scan();
       n_ld_tokens = 2;
       scheduled_unscanned_cown = false;
+      core->scheduled_unscanned_cown = false;
       Logging::cout() << "Enqueued LD check point" << Logging::endl;
     }
 
@@ -759,8 +1370,9 @@ namespace verona::rt
 
       assert(this->core != nullptr);
       // TODO This will become false once we have multiple scheduler threads per
-      // core.
-      assert(this->core->total_cowns == count);
+      // core.  A retiring core can add its cowns concurrently, see
+      // `hand_over_cowns`.
+      assert(this->core->total_cowns >= count);
       this->core->free_cowns -= removed_count;
       this->core->total_cowns -= removed_count;
 
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "../pal/threadpoolbuilder.h"
+#include "behaviourlatency.h"
 #include "test/logging.h"
 #include "threadstate.h"
 #ifdef USE_SYSTEMATIC_TESTING
@@ -18,6 +19,7 @@
 #include <condition_variable>
 #include <mutex>
 #include <snmalloc/snmalloc.h>
+#include <tuple>
 
 namespace verona::rt
 {
@@ -37,6 +39,11 @@ namespace verona::rt
     static constexpr uint64_t TSC_PAUSE_SLOP = 1'000'000;
     static constexpr uint64_t TSC_UNPAUSE_SLOP = TSC_PAUSE_SLOP / 2;
 
+    /// Utilisation, as a percentage, below which the controller retires a
+    /// core, and above which it adds one, see `set_elastic`.
+    static constexpr uint64_t ELASTIC_LOW_UTILISATION = 25;
+    static constexpr uint64_t ELASTIC_HIGH_UTILISATION = 90;
+
     bool detect_leaks = true;
     size_t incarnation = 1;
 
@@ -56,8 +63,9 @@ namespace verona::rt
 
     /**
      * Used to track unpause calls.  Threads unpausing
-     * attempt to catch unpause_epoch up to pause_epoch,
-     * and thus ensure threads are running.
+     * move unpause_epoch towards pause_epoch, by one for
+     * each thread they wake, and thus ensure threads are
+     * running.
      */
     std::atomic<uint64_t> unpause_epoch{0};
 
@@ -84,6 +92,43 @@ namespace verona::rt
 
     bool fair = false;
 
+    /// Batching of messages by a cown, see `set_batch_limit`.
+    size_t batch_limit = 100;
+#ifdef USE_SYSTEMATIC_TESTING
+    // Timing is not reproducible, so would break replaying a seed.
+    uint64_t batch_cycles = 0;
+#else
+    uint64_t batch_cycles = 100'000;
+#endif
+
+    /// Rebalancing between the cores, see `set_rebalance`.
+    uint64_t rebalance_cycles = 0;
+    size_t rebalance_depth = 0;
+
+    /// Most cowns taken by one steal, see `set_steal_batch`.
+    size_t steal_batch = 1;
+
+    /// How long an idle thread looks for work before pausing, see
+    /// `set_spin_budget`.
+    uint64_t spin_cycles = 1'000'000;
+
+    /// Budget for running behaviours inline, see `set_inline_budget`.
+    size_t inline_depth = 0;
+    size_t inline_count = 0;
+
+    /// How many cores the threads should run on, see `set_active_cores`.
+    std::atomic<size_t> target_cores = 0;
+
+    /// Automatic control of `target_cores`, see `set_elastic`.
+    size_t elastic_min = 0;
+    size_t elastic_max = 0;
+    uint64_t elastic_cycles = 0;
+    std::atomic<uint64_t> last_resize = 0;
+
+    /// Starts threads added while running, see `add_core`.
+    ThreadPoolBuilder* builder = nullptr;
+    void (*spawn)(ThreadPoolBuilder&, T*) = nullptr;
+
     ThreadState state;
 
     /// Pool of cores shared by the scheduler threads.
@@ -93,6 +138,9 @@ namespace verona::rt
     std::atomic<size_t> systematic_ids = 0;
 
   public:
+    /// Upper limit for `set_steal_batch`.
+    static constexpr size_t MAX_STEAL_BATCH = 32;
+
     static ThreadPool<T, C>& get()
     {
       SNMALLOC_REQUIRE_CONSTINIT static ThreadPool<T, C> global_thread_pool;
@@ -175,6 +223,13 @@ namespace verona::rt
       assert(prev_count != 0);
       Logging::cout() << "Remove external event source (now "
                       << (prev_count - 1) << ")" << Logging::endl;
+
+      // The last thread to pause while there were external event sources is
+      // still counted as active, and `unpause` may have woken another thread
+      // instead.  Wake them all, so that the last to pause begins the
+      // teardown.
+      if (prev_count == 1)
+        h.unpause_all();
     }
 
     static void set_fair(bool fair)
@@ -184,6 +239,202 @@ namespace verona::rt
       s.fair = fair;
     }
 
+    /**
+     * Configure how many messages a cown handles each time it is run.
+     *
+     * A cown handles at most `limit` messages per run.  If `cycles` is not
+     * zero, each cown also measures how long its behaviours take, and sizes
+     * its batches to run for about `cycles` ticks: cowns with short behaviours
+     * amortise being scheduled over many messages, while cowns with long
+     * behaviours give way to the rest of the scheduler queue after a few.
+     */
+    static void set_batch_limit(size_t limit, uint64_t cycles)
+    {
+      Logging::cout() << "Set batch limit: " << limit << " messages, " << cycles
+                      << " cycles" << Logging::endl;
+      assert(limit != 0);
+      auto& s = get();
+      s.batch_limit = limit;
+      s.batch_cycles = cycles;
+    }
+
+    static size_t get_batch_limit()
+    {
+      return get().batch_limit;
+    }
+
+    static uint64_t get_batch_cycles()
+    {
+      return get().batch_cycles;
+    }
+
+    /**
+     * Configure when a scheduler thread moves a cown from another core to its
+     * own, while it still has work.
+     *
+     * With `set_fair`, a thread steals a cown each time its token comes round
+     * its queue, which can take a long time when the queue is deep.  If
+     * `cycles` is not zero, a thread also steals once `cycles` ticks have
+     * passed since it last did.  If `depth` is not zero, a thread also steals
+     * when its next core's queue is estimated to be `depth` cowns deeper than
+     * its own, checking one core each time it takes a cown, see
+     * `SchedulerStats::queue_depth`.  Both are zero by default.
+     */
+    static void set_rebalance(uint64_t cycles, size_t depth)
+    {
+      Logging::cout() << "Set rebalance: " << cycles << " cycles, " << depth
+                      << " cowns" << Logging::endl;
+      auto& s = get();
+      s.rebalance_cycles = cycles;
+      s.rebalance_depth = depth;
+    }
+
+    /**
+     * Allow a scheduler thread that has run out of work to take up to half
+     * of another core's queue in one steal, and at most `max` cowns.  It runs
+     * the first, and moves the rest onto its own queue with a single enqueue,
+     * so that it does not have to come back for each of them.  Stealing for
+     * fairness still takes one cown.  A `max` of one, the default, takes one
+     * cown each time, and `max` is at most `MAX_STEAL_BATCH`.
+     */
+    static void set_steal_batch(size_t max)
+    {
+      Logging::cout() << "Set steal batch: " << max << " cowns"
+                      << Logging::endl;
+      if (max == 0)
+        max = 1;
+      get().steal_batch = (max < MAX_STEAL_BATCH) ? max : MAX_STEAL_BATCH;
+    }
+
+    /**
+     * Set how long, in cycles, a scheduler thread that has run out of work
+     * keeps trying to steal before it pauses.  Spinning for longer wakes up
+     * to new work sooner, at the cost of CPU time at low load.  The default
+     * is 1,000,000 cycles.  Systematic testing ignores this, and pauses at
+     * random.
+     */
+    static void set_spin_budget(uint64_t cycles)
+    {
+      Logging::cout() << "Set spin budget: " << cycles << " cycles"
+                      << Logging::endl;
+      get().spin_cycles = cycles;
+    }
+
+    /**
+     * Allow a scheduler thread that acquires the last cown of a behaviour to
+     * run the behaviour inline, instead of rescheduling that cown.
+     *
+     * Inline behaviours nest at most `depth` deep, and at most `count` are run
+     * each time the scheduler thread runs a cown from its queue, so that they
+     * cannot starve the rest of its queue.  A `depth` of zero, the default,
+     * disables inline execution.
+     */
+    static void set_inline_budget(size_t depth, size_t count)
+    {
+      Logging::cout() << "Set inline budget: " << depth << " deep, " << count
+                      << " per cown" << Logging::endl;
+      auto& s = get();
+      s.inline_depth = depth;
+      s.inline_count = count;
+    }
+
+    /**
+     * Set how many cores the scheduler threads run on, initially the count
+     * passed to `init`.  This can be called from any thread while the runtime
+     * is running, and takes effect once the scheduler threads reach a point
+     * where it is safe, outside of a leak detector cycle.
+     *
+     * A core is added by starting a thread on it, reusing a core that has
+     * been retired if there is one.  A thread retires its core by moving the
+     * cowns in its queues, and those the core owns, to the next core, and
+     * then exits.  The retired core stays in the ring of cores until the end
+     * of `run`.  A core that live cowns are pinned to is not retired, see
+     * `Cown::pin`, so there may stay more active cores than `count`.
+     */
+    static void set_active_cores(size_t count)
+    {
+      Logging::cout() << "Set active cores: " << count << Logging::endl;
+      if (count == 0)
+        count = 1;
+      auto& s = get();
+      s.target_cores = count;
+
+      // Wake the threads to act on it.
+      s.unpause_all();
+    }
+
+    /**
+     * Returns the number of cores that have a scheduler thread, including any
+     * that have been added but whose thread has not started yet.
+     */
+    static size_t get_active_cores()
+    {
+      return get().core_pool.active_count;
+    }
+
+    /**
+     * Let the scheduler threads choose how many cores to run on, from `min`
+     * to `max`, see `set_active_cores`.  Each thread measures the utilisation
+     * of its core every `cycles`: the proportion of the time it was not
+     * paused.  A thread with low utilisation retires a core, and one with
+     * high utilisation and work waiting in its queue adds one, at most one
+     * change every `cycles` across all the threads.  A `cycles` of zero, the
+     * default, disables this.  Systematic testing ignores the utilisation,
+     * and changes the number of cores at random.
+     */
+    static void set_elastic(size_t min, size_t max, uint64_t cycles)
+    {
+      Logging::cout() << "Set elastic: " << min << " to " << max
+                      << " cores, every " << cycles << " cycles"
+                      << Logging::endl;
+      assert((min != 0) && (min <= max));
+      auto& s = get();
+      s.elastic_min = min;
+      s.elastic_max = max;
+      s.elastic_cycles = cycles;
+    }
+
+    /**
+     * Returns the totals of the scheduler statistics over all cores.
+     *
+     * The scheduler threads are not stopped, so each counter is read at a
+     * slightly different time.  Must only be called between `init` and the
+     * end of `run`.
+     */
+    static SchedulerStats::Snapshot snapshot_stats()
+    {
+      SchedulerStats::Snapshot snapshot;
+      auto& pool = get().core_pool;
+      Core<C>* c = pool.first_core;
+      for (size_t i = 0; i < pool.core_count; i++)
+      {
+        c->stats.snapshot(snapshot);
+        c = c->next;
+      }
+      return snapshot;
+    }
+
+    /**
+     * Record how long each behaviour waits to be run, and runs for, in
+     * histograms per type of behaviour, see `BehaviourLatency`.  Behaviours
+     * scheduled while this is disabled, the default, are not timed.
+     */
+    static void set_behaviour_latency(bool enable)
+    {
+      Logging::cout() << "Set behaviour latency: " << enable << Logging::endl;
+      BehaviourLatency::enable(enable);
+    }
+
+    /**
+     * Calls `f` with the `BehaviourLatency::Histograms` of each type of
+     * behaviour recorded so far.  Can be called while the runtime is running.
+     */
+    template<typename F>
+    static void for_each_behaviour_latency(F f)
+    {
+      BehaviourLatency::for_each(f);
+    }
+
     static bool is_teardown_in_progress()
     {
       return get().teardown_in_progress;
@@ -195,6 +446,27 @@ namespace verona::rt
       return local;
     }
 
+    /**
+     * Returns the `index`th core that is not retired, which the `index`th
+     * scheduler thread runs on if none have been added or retired.  Must only
+     * be called between `init` and the end of `run`.
+     */
+    static Core<C>* core(size_t index)
+    {
+      auto& pool = get().core_pool;
+      Core<C>* c = pool.first_core;
+      while (c->retired)
+        c = c->next;
+      for (size_t i = 0; i < (index % pool.active_count); i++)
+      {
+        do
+        {
+          c = c->next;
+        } while (c->retired);
+      }
+      return c;
+    }
+
     static Core<C>* round_robin()
     {
       static thread_local size_t incarnation;
@@ -210,6 +482,9 @@ namespace verona::rt
         nonlocal = nonlocal->next;
       }
 
+      while (nonlocal->retired)
+        nonlocal = nonlocal->next;
+
       return nonlocal;
     }
 
@@ -306,6 +581,7 @@ namespace verona::rt
         abort();
 
       thread_count = count;
+      target_cores = count;
       teardown_in_progress = false;
 
       // Initialize the corepool.
@@ -336,24 +612,38 @@ namespace verona::rt
     template<typename... Args>
     void run_with_startup(void (*startup)(Args...), Args... args)
     {
+      Startup<Args...>::startup = startup;
+      Startup<Args...>::args = std::make_tuple(args...);
+      spawn = &Startup<Args...>::spawn;
+
       {
-        ThreadPoolBuilder builder(thread_count);
+        size_t count = thread_count;
+        ThreadPoolBuilder builder(count);
 
         Logging::cout() << "Starting all threads" << Logging::endl;
         auto first_core = core_pool.first_core;
         auto curr_core = first_core;
-        for (size_t i = 0; i < thread_count; i++)
+        for (size_t i = 0; i < count; i++)
         {
           T* t = threads.pop_free();
           if (t == nullptr)
             abort();
           t->set_core(curr_core);
           threads.add_active(t);
+
+          // Threads can only be added or retired, see `set_active_cores`,
+          // once the others have been taken from the free list.  The last
+          // thread runs on this one.
+          if (i == count - 1)
+            this->builder = &builder;
+
           builder.add_thread(t->core->affinity, &T::run, t, startup, args...);
           curr_core = curr_core->next;
         }
       }
       Logging::cout() << "All threads stopped" << Logging::endl;
+      builder = nullptr;
+      core_pool.destroy_retired_queues(ThreadAlloc::get());
       threads.dealloc_lists();
       Logging::cout() << "All threads deallocated" << Logging::endl;
 
@@ -374,6 +664,125 @@ namespace verona::rt
     }
 
   private:
+    /**
+     * The startup function and arguments passed to `run_with_startup`, for
+     * the threads added by `add_core`.
+     */
+    template<typename... Args>
+    struct Startup
+    {
+      static inline void (*startup)(Args...) = nullptr;
+      static inline std::tuple<Args...> args;
+
+      static void spawn(ThreadPoolBuilder& builder, T* t)
+      {
+        std::apply(
+          [&](Args... a) {
+            builder.add_extra_thread(
+              t->core->affinity, &T::run, t, startup, a...);
+          },
+          args);
+      }
+    };
+
+    /**
+     * Returns true if threads can be added or retired now, see
+     * `set_active_cores`.  Threads are only counted in the votes of the leak
+     * detector, and at the teardown barrier, between its cycles.  Must be
+     * called holding the lock.
+     */
+    bool can_resize()
+    {
+      return !teardown_in_progress &&
+        (state.get_state() == ThreadState::NotInLD) && (builder != nullptr);
+    }
+
+    /**
+     * Starts a thread on another core, if there are fewer than
+     * `set_active_cores` asks for.  Called by a scheduler thread outside of a
+     * leak detector cycle.
+     */
+    void add_core()
+    {
+      T* t;
+      {
+        auto h = sync.handle(local());
+        if (!can_resize() || (core_pool.active_count >= target_cores))
+          return;
+
+        t = new T;
+        t->systematic_id = systematic_ids++;
+#ifdef USE_SYSTEMATIC_TESTING
+        t->local_systematic =
+          Systematic::create_systematic_thread(t->systematic_id);
+#endif
+        // The new thread joins at the same point of the leak detector as the
+        // others.
+        t->send_epoch = local()->send_epoch;
+        t->prev_epoch = local()->prev_epoch;
+        t->set_core(core_pool.add());
+        threads.add_active(t);
+        thread_count++;
+        state.add_thread();
+      }
+
+      Logging::cout() << "Adding thread on core " << t->core->affinity
+                      << Logging::endl;
+      spawn(*builder, t);
+    }
+
+    /**
+     * Returns true, having counted one fewer active core, if there are more
+     * than `set_active_cores` asks for, so a thread can start to retire.  Must
+     * be called holding the lock.
+     */
+    bool retire_core()
+    {
+      if (!can_resize() || (core_pool.active_count <= target_cores))
+        return false;
+
+      core_pool.active_count--;
+      return true;
+    }
+
+    /**
+     * Counts a core whose thread had started to retire as active again, see
+     * `retire_core`.  Must be called holding the lock.
+     */
+    void unretire_core()
+    {
+      core_pool.active_count++;
+    }
+
+    /**
+     * Moves `target_cores` up by one if `grow`, and otherwise down by one,
+     * within the bounds of `set_elastic`, at most once every `elastic_cycles`.
+     */
+    void request_resize(bool grow)
+    {
+      auto last = last_resize.load(std::memory_order_relaxed);
+#ifndef USE_SYSTEMATIC_TESTING
+      auto now = Aal::tick();
+      if ((now - last) < elastic_cycles)
+        return;
+#else
+      auto now = last + 1;
+#endif
+      if (!last_resize.compare_exchange_strong(last, now))
+        return;
+
+      size_t target = target_cores;
+      if (grow && (target < elastic_max))
+        target_cores = target + 1;
+      else if (!grow && (target > elastic_min))
+        target_cores = target - 1;
+      else
+        return;
+
+      Logging::cout() << "Elastic resize to " << target_cores << " cores"
+                      << Logging::endl;
+    }
+
     inline ThreadState::State next_state(ThreadState::State s)
     {
       auto h = sync.handle(local());
@@ -388,7 +797,7 @@ namespace verona::rt
       {
         Logging::cout() << "Checking for pending work on thread " << c->affinity
                         << Logging::endl;
-        if (!c->q.nothing_old())
+        if (!c->nothing_old())
         {
           Logging::cout() << "Found pending work!" << Logging::endl;
           return true;
@@ -471,9 +880,27 @@ namespace verona::rt
       return true;
     }
 
+    /**
+     * Called after work is added.  Wakes one paused thread to take it, if
+     * any thread may be paused, and returns true if this call woke one.
+     */
     bool unpause()
     {
-      Logging::cout() << "unpause()" << Logging::endl;
+      return unpause(false);
+    }
+
+    /**
+     * As `unpause`, but wakes all of the paused threads.  The leak detector
+     * uses this to bring all of the threads into its protocol.
+     */
+    bool unpause_all()
+    {
+      return unpause(true);
+    }
+
+    bool unpause(bool all)
+    {
+      Logging::cout() << "unpause(" << all << ")" << Logging::endl;
 
       // Work should be added before checking for the runtime_pause.
       Barrier::compiler();
@@ -496,11 +923,18 @@ namespace verona::rt
       // monotonically increase unpause_epoch.
       local_pause_epoch = pause_epoch.load(std::memory_order_acquire);
 
+      // Another unpause may have caught up with a pause since the first
+      // load, so moving the epoch on by one would overtake pause_epoch.
+      if (local_unpause_epoch == local_pause_epoch)
+        return false;
+
       yield();
 
-      // Attempt to catch up epoch.
+      // Attempt to catch up epoch, or to move it on by the one thread this
+      // call wakes.  Each paused thread is ahead in pause_epoch, so while
+      // any are paused, another unpause will not exit early.
       bool success = unpause_epoch.compare_exchange_strong(
-        local_unpause_epoch, local_pause_epoch);
+        local_unpause_epoch, all ? local_pause_epoch : local_unpause_epoch + 1);
 
       yield();
 
@@ -508,8 +942,16 @@ namespace verona::rt
       {
         // This grabs the scheduler lock to ensure threads have seen CAS before
         // we notify.
-        Logging::cout() << "Wake all threads" << Logging::endl;
-        sync.unpause_all(local());
+        if (all)
+        {
+          Logging::cout() << "Wake all threads" << Logging::endl;
+          sync.unpause_all(local());
+        }
+        else
+        {
+          Logging::cout() << "Wake one thread" << Logging::endl;
+          sync.unpause_one(local());
+        }
         return true;
       }
       // Another thread won the CAS race, and is responsible for waking up.
@@ -177,7 +177,17 @@ namespace verona::rt
               return vote<Scan, AllInScan>(total_votes);
 
             case Scan:
+            {
+              // The thread that wanted the LD has already voted, so a lone
+              // thread, for example after the others retired, has no vote to
+              // wait for.
+              if (vote_yes == total_votes)
+              {
+                reset<AllInScan>();
+                return AllInScan;
+              }
               return Scan;
+            }
 
             default:
               abort();
@@ -324,6 +334,24 @@ namespace verona::rt
       internal_state.active_threads++;
     }
 
+    /// Count a thread added while running.
+    /// @warn Should be holding the threadpool lock, outside of a leak
+    /// detector cycle.
+    void add_thread()
+    {
+      internal_state.barrier_count++;
+      internal_state.active_threads++;
+    }
+
+    /// Stop counting a thread that has retired while running.
+    /// @warn Should be holding the threadpool lock, outside of a leak
+    /// detector cycle.
+    void remove_thread()
+    {
+      internal_state.barrier_count--;
+      internal_state.active_threads--;
+    }
+
   private:
     template<State intermediate, State next>
     State vote(size_t total_votes)
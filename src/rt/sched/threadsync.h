@@ -135,6 +135,25 @@ namespace verona::rt
       Logging::cout() << "Unpause all done" << Logging::endl;
     }
 
+    /**
+     * Wake the most recently paused thread, if there is one.
+     * `ThreadSyncSystematic` wakes in the same order.
+     */
+    void unpause_one(T*)
+    {
+      Logging::cout() << "Unpause one" << Logging::endl;
+      lock.lock();
+      auto* curr = waiters;
+      if (curr != nullptr)
+        waiters = curr->next;
+      unlock();
+
+      // Don't need to hold the lock to wake up the waiter.
+      if (curr != nullptr)
+        curr->sem.wake();
+      Logging::cout() << "Unpause one done" << Logging::endl;
+    }
+
     class ThreadSyncHandle
     {
       T* thread;
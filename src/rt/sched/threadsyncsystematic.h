@@ -4,8 +4,10 @@
 #pragma once
 #include "test/logging.h"
 
+#include <algorithm>
 #include <condition_variable>
 #include <mutex>
+#include <vector>
 
 /**
  * This file contains the synchronisation implementation for suspending
@@ -27,6 +29,12 @@ namespace verona::rt
     /// ignore.
     size_t unpause_incarnation = 0;
 
+    /// Each pause takes a ticket, which stays in `paused` until the thread
+    /// is woken.  `unpause_one` wakes the most recently paused thread, as
+    /// `ThreadSync` does.
+    size_t next_ticket = 0;
+    std::vector<size_t> paused;
+
     void acquire()
     {
       auto guard = [&]() { return !m; };
@@ -60,10 +68,14 @@ namespace verona::rt
         sync.m = false;
 
         auto incarnation = sync.unpause_incarnation;
+        auto ticket = sync.next_ticket++;
+        sync.paused.push_back(ticket);
         // Copy for capture by value
         auto sync_ptr = &sync;
-        auto guard = [incarnation, sync_ptr]() {
-          return incarnation != sync_ptr->unpause_incarnation;
+        auto guard = [incarnation, ticket, sync_ptr]() {
+          auto& p = sync_ptr->paused;
+          return (incarnation != sync_ptr->unpause_incarnation) ||
+            (std::find(p.begin(), p.end(), ticket) == p.end());
         };
         // Guard should not hold here.
         assert(!guard());
@@ -84,6 +96,7 @@ namespace verona::rt
           // Treat as a yield pointer if thread is under systematic testing
           // control.
           sync.unpause_incarnation++;
+          sync.paused.clear();
           Systematic::yield();
         }
       }
@@ -109,5 +122,18 @@ namespace verona::rt
     {
       handle(me).unpause_all();
     }
+
+    /**
+     * This unpauses the most recently paused thread, if any.
+     */
+    void unpause_one(T* me)
+    {
+      {
+        auto h = handle(me);
+        if (!paused.empty())
+          paused.pop_back();
+      }
+      Systematic::yield();
+    }
   };
 }
@@ -0,0 +1,115 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Checks the latency histogram buckets, and that each type of behaviour gets
+ * its own histograms when `Scheduler::set_behaviour_latency` is enabled.
+ */
+
+#include <test/harness.h>
+
+static constexpr size_t BEHAVIOURS = 20;
+
+struct Cell : public VCown<Cell>
+{
+  size_t count = 0;
+};
+
+struct Single : public VBehaviour<Single>
+{
+  Cell* cell;
+
+  Single(Cell* cell) : cell(cell) {}
+
+  void f()
+  {
+    cell->count++;
+  }
+};
+
+struct Pair : public VBehaviour<Pair>
+{
+  Cell* a;
+  Cell* b;
+
+  Pair(Cell* a, Cell* b) : a(a), b(b) {}
+
+  void f()
+  {
+    a->count++;
+    b->count++;
+  }
+};
+
+void test_buckets()
+{
+  uint64_t prev = 0;
+  for (uint64_t v = 0; v < 100'000; v++)
+  {
+    auto b = LatencyHistogram::bucket(v);
+    check(b >= prev);
+    check(LatencyHistogram::bucket_min(b) <= v);
+    check(LatencyHistogram::bucket_min(b + 1) > v);
+    prev = b;
+  }
+
+  check(LatencyHistogram::bucket(~(uint64_t)0) < LatencyHistogram::BUCKETS);
+
+  LatencyHistogram h;
+  for (uint64_t v = 1; v <= 100; v++)
+    h.record(v * 1000);
+
+  check(h.total() == 100);
+  check(h.percentile(50) <= 50'000);
+  check(h.percentile(50) >= 50'000 - 50'000 / LatencyHistogram::SUB_BUCKETS);
+  check(h.percentile(99) >= h.percentile(50));
+}
+
+void test_behaviours()
+{
+  auto& alloc = ThreadAlloc::get();
+  auto* a = new Cell;
+  auto* b = new Cell;
+
+  for (size_t i = 0; i < BEHAVIOURS; i++)
+  {
+    Cown::schedule<Single>(a, a);
+    Cown* both[2] = {a, b};
+    Cown::schedule<Pair>(2, both, a, b);
+  }
+
+  Cown::release(alloc, a);
+  Cown::release(alloc, b);
+}
+
+/**
+ * Returns how many behaviours of a type have been timed.
+ */
+uint64_t timed(const Behaviour::Descriptor* descriptor)
+{
+  uint64_t result = 0;
+  Scheduler::for_each_behaviour_latency(
+    [&](const BehaviourLatency::Histograms& h) {
+      if (h.descriptor != descriptor)
+        return;
+
+      check(h.queued.total() == h.running.total());
+      check(h.acquiring.total() == h.running.total());
+      result = h.running.total();
+    });
+  return result;
+}
+
+int main(int argc, char** argv)
+{
+  test_buckets();
+
+  SystematicTestHarness harness(argc, argv);
+  Scheduler::set_behaviour_latency(true);
+  harness.run(test_behaviours);
+
+  auto seeds = harness.seed_upper - harness.seed_lower;
+  check(timed(Single::type_descriptor()) == seeds * BEHAVIOURS);
+  check(timed(Pair::type_descriptor()) == seeds * BEHAVIOURS);
+  return 0;
+}
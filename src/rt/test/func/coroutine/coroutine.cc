@@ -0,0 +1,120 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Checks coroutine behaviours, see `async_behaviour`: that they resume with
+ * the cowns they wait for acquired, in the order of the other behaviours on
+ * those cowns, and with the values of promises.
+ */
+
+#include <cpp/coroutine.h>
+#include <test/harness.h>
+
+using namespace verona::cpp;
+
+static constexpr size_t WORKERS = 4;
+static constexpr size_t STEPS = 10;
+
+struct Account
+{
+  int64_t balance = 0;
+  // Set while a behaviour on this account is running.
+  bool busy = false;
+};
+
+struct Log
+{
+  size_t transfers = 0;
+  size_t reads = 0;
+  size_t values = 0;
+
+  ~Log()
+  {
+    check(transfers == WORKERS * STEPS);
+    check(reads == WORKERS * STEPS);
+    check(values == WORKERS);
+  }
+};
+
+async_behaviour worker(
+  cown_ptr<Account> a,
+  cown_ptr<Account> b,
+  cown_ptr<Log> log,
+  Promise<size_t>::PromiseR value)
+{
+  for (size_t i = 0; i < STEPS; i++)
+  {
+    {
+      auto [x, y] = co_await when(a, b);
+      check(!x->busy && !y->busy);
+      x->busy = true;
+      y->busy = true;
+      x->balance -= (int64_t)i;
+      y->balance += (int64_t)i;
+      check(x->balance + y->balance == 0);
+      x->busy = false;
+      y->busy = false;
+    }
+
+    {
+      auto x = co_await when(read(a));
+      check(!x->busy);
+    }
+
+    // Resume on a scheduler thread with no cowns acquired.
+    co_await when();
+
+    auto l = co_await when(log);
+    l->transfers++;
+    l->reads++;
+  }
+
+  auto v = co_await std::move(value);
+  check(std::holds_alternative<size_t>(v));
+  check(std::get<size_t>(v) == 42);
+
+  auto l = co_await when(log);
+  l->values++;
+}
+
+/**
+ * Interleaves ordinary behaviours with the coroutines, which must see them
+ * as atomic.
+ */
+void spoil(cown_ptr<Account> a)
+{
+  for (size_t i = 0; i < STEPS; i++)
+    when(a) << [](acquired_cown<Account> a) {
+      check(!a->busy);
+      a->busy = true;
+      yield();
+      a->busy = false;
+    };
+}
+
+void test_coroutine()
+{
+  auto a = make_cown<Account>();
+  auto b = make_cown<Account>();
+  auto log = make_cown<Log>();
+
+  auto pp = Promise<size_t>::create_promise();
+  auto r = std::move(pp.first);
+
+  for (size_t i = 0; i < WORKERS; i++)
+    worker(a, b, log, r);
+
+  spoil(a);
+  spoil(b);
+
+  when() << [w = std::move(pp.second)]() mutable {
+    Promise<size_t>::fulfill(std::move(w), 42);
+  };
+}
+
+int main(int argc, char** argv)
+{
+  SystematicTestHarness harness(argc, argv);
+  harness.run(test_coroutine);
+  return 0;
+}
@@ -0,0 +1,166 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Checks that scheduler threads can be added and retired while behaviours
+ * run, by `set_active_cores` and by the controller of `set_elastic`.
+ *
+ * Each chain of Hops runs round a ring of nodes, so the retiring cores have
+ * queued cowns and owned cowns to hand over.  The first ring's first node is
+ * pinned, and must stay on the same thread, as its core is not retired.  The
+ * rings are cycles, which the leak detector must collect once the chains end,
+ * and the Hops ask for leak detector cycles while the number of cores
+ * changes.
+ *
+ * Then a cown is pinned to each core, and dropped once a behaviour has run on
+ * it.  A chain of Shrinks asks for a single core, and checks that the cores
+ * are retired once their pinned cowns have been collected.
+ */
+
+#include <test/harness.h>
+
+static constexpr size_t RING_SIZE = 5;
+static constexpr size_t HOPS = 100;
+static constexpr size_t SHRINK_HOPS = 100'000;
+
+static std::atomic<size_t> hops = 0;
+static std::atomic<size_t> shrunk = 0;
+
+struct Node : public VCown<Node>
+{
+  Node* next = nullptr;
+  void* thread = nullptr;
+
+  void trace(ObjectStack& fields) const
+  {
+    if (next != nullptr)
+      fields.push(next);
+  }
+};
+
+struct Hop : public VBehaviour<Hop>
+{
+  Node* node;
+  size_t left;
+  size_t cores;
+  bool resize;
+
+  Hop(Node* node, size_t left, size_t cores, bool resize)
+  : node(node), left(left), cores(cores), resize(resize)
+  {}
+
+  void f()
+  {
+    if (node->is_pinned())
+    {
+      if (node->thread == nullptr)
+        node->thread = Scheduler::local();
+      check(node->thread == Scheduler::local());
+    }
+
+    hops++;
+    if (left == 0)
+      return;
+
+    if (resize && ((left % 16) == 0))
+    {
+      // Cycle through fewer, the same and more cores than the initial count.
+      size_t targets[] = {1, cores, cores * 2};
+      Scheduler::set_active_cores(targets[(left / 16) % 3]);
+    }
+
+    if ((left % 40) == 0)
+      Scheduler::want_ld();
+
+    Cown::schedule<Hop>(node->next, node->next, left - 1, cores, resize);
+  }
+};
+
+struct Use : public VBehaviour<Use>
+{
+  Node* node;
+
+  Use(Node* node) : node(node) {}
+
+  void f()
+  {
+    check(node->is_pinned());
+  }
+};
+
+struct Shrink : public VBehaviour<Shrink>
+{
+  Node* node;
+  size_t left;
+
+  Shrink(Node* node, size_t left) : node(node), left(left) {}
+
+  void f()
+  {
+    if (left == SHRINK_HOPS)
+      Scheduler::set_active_cores(1);
+
+    if (Scheduler::get_active_cores() == 1)
+    {
+      shrunk++;
+      return;
+    }
+
+    check(left != 0);
+    Cown::schedule<Shrink>(node, node, left - 1);
+  }
+};
+
+void test_elastic(size_t cores, bool resize)
+{
+  for (size_t i = 0; i < cores; i++)
+  {
+    Node* ring[RING_SIZE];
+    for (auto& node : ring)
+      node = new Node;
+
+    // The reference from creating each node is held by the one before it,
+    // so the ring only keeps itself alive.
+    if (i == 0)
+      ring[0]->pin();
+    for (size_t j = 0; j < RING_SIZE; j++)
+      ring[j]->next = ring[(j + 1) % RING_SIZE];
+
+    Cown::schedule<Hop>(ring[0], ring[0], HOPS, cores, resize);
+  }
+}
+
+void test_unpin(size_t cores)
+{
+  auto& alloc = ThreadAlloc::get();
+  for (size_t i = 0; i < cores; i++)
+  {
+    auto* node = new Node;
+    node->pin(i);
+    Cown::schedule<Use>(node, node);
+    Cown::release(alloc, node);
+  }
+
+  auto* node = new Node;
+  Cown::schedule<Shrink>(node, node, SHRINK_HOPS);
+  Cown::release(alloc, node);
+}
+
+int main(int argc, char** argv)
+{
+  SystematicTestHarness harness(argc, argv);
+  auto seeds = harness.seed_upper - harness.seed_lower;
+
+  harness.run(test_elastic, harness.cores, true);
+  check(hops == seeds * harness.cores * (HOPS + 1));
+
+  hops = 0;
+  Scheduler::set_elastic(1, harness.cores * 2, 10'000);
+  harness.run(test_elastic, harness.cores, false);
+  Scheduler::set_elastic(1, 1, 0);
+  check(hops == seeds * harness.cores * (HOPS + 1));
+
+  harness.run(test_unpin, harness.cores);
+  check(shrunk == seeds);
+  return 0;
+}
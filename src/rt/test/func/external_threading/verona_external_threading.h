@@ -29,6 +29,23 @@ namespace verona::rt
     {
       return index;
     }
+
+    /**
+     * Returns the NUMA node of the CPU returned by Topology::get(index).
+     */
+    size_t get_numa_node(size_t)
+    {
+      return 0;
+    }
+
+    /**
+     * Returns an identifier for the group of CPUs sharing a last level cache
+     * with the CPU returned by Topology::get(index).
+     */
+    size_t get_complex(size_t)
+    {
+      return 0;
+    }
   };
 
   namespace cpu
@@ -73,5 +73,9 @@ int main(int argc, char** argv)
 {
   SystematicTestHarness harness(argc, argv);
   harness.run(basic_test);
+
+  // Also rebalance on elapsed time and queue depth.
+  Scheduler::set_rebalance(100'000, 2);
+  harness.run(basic_test);
   return 0;
 }
@@ -21,6 +21,13 @@ struct A : public VCown<A>
 int constexpr n_cowns = 6;
 double elapsed_secs[n_cowns];
 
+// How far each cown has to go, and how far behind the furthest cown was when
+// the first finished, which measures how quickly the scheduler evened out
+// the cowns' progress.
+std::atomic<int> remaining[n_cowns];
+std::atomic<bool> first_finished = false;
+int furthest_behind = 0;
+
 struct Loop : public VBehaviour<Loop>
 {
   A* a;
@@ -36,8 +43,16 @@ struct Loop : public VBehaviour<Loop>
       a->begin = clock();
     }
 
+    remaining[id].store(count, std::memory_order_relaxed);
+
     if (count == 0)
     {
+      if (!first_finished.exchange(true))
+      {
+        for (auto& r : remaining)
+          furthest_behind = std::max(furthest_behind, r.load());
+      }
+
       clock_t end = clock();
       double elapsed_second = double(end - a->begin) / CLOCKS_PER_SEC;
       elapsed_secs[id] = elapsed_second;
@@ -91,17 +106,18 @@ void assert_variance()
   UNUSED(max);
 }
 
-int main()
+void run(const char* policy)
 {
-#ifdef USE_SYSTEMATIC_TESTING
-  std::cout << "This test does not make sense to run systematically."
-            << std::endl;
-#else
   size_t cores = 2;
   Scheduler& sched = Scheduler::get();
   sched.init(cores);
   sched.set_fair(true);
 
+  for (auto& r : remaining)
+    r = start_count;
+  first_finished = false;
+  furthest_behind = 0;
+
   auto& alloc = ThreadAlloc::get();
   (void)alloc;
 
@@ -111,7 +127,27 @@ int main()
   Cown::release(alloc, b);
   sched.run();
   snmalloc::debug_check_empty<snmalloc::Alloc::Config>();
+
+  printf(
+    "%s: furthest behind by %d%% when the first cown finished\n",
+    policy,
+    (furthest_behind * 100) / start_count);
   assert_variance();
+}
+
+int main()
+{
+#ifdef USE_SYSTEMATIC_TESTING
+  std::cout << "This test does not make sense to run systematically."
+            << std::endl;
+#else
+  run("token");
+
+  // Also rebalance on elapsed time and queue depth, see
+  // `ThreadPool::set_rebalance`.
+  Scheduler::set_rebalance(100'000, 2);
+  run("rebalance");
+  Scheduler::set_rebalance(0, 0);
 
   puts("done");
 #endif
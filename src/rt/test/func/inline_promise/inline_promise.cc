@@ -0,0 +1,160 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Checks `InlinePromise`: that the continuation runs once, with the value or
+ * an error, whichever of `then` and `fulfill` comes first, and that a
+ * continuation passed with a cown runs in a behaviour on that cown.
+ */
+
+#include <test/harness.h>
+
+using namespace std;
+
+using IntPromise = InlinePromise<int>;
+
+struct Counter : public VCown<Counter>
+{
+  // Set while a behaviour on this cown is running.
+  bool busy = false;
+  size_t count = 0;
+};
+
+static std::atomic<size_t> values = 0;
+static std::atomic<size_t> errors = 0;
+
+void expect_value(IntPromise::Result val)
+{
+  check(std::holds_alternative<int>(val));
+  check(std::get<int>(val) == 42);
+  values++;
+}
+
+void expect_error(IntPromise::Result val)
+{
+  check(std::holds_alternative<IntPromise::PromiseErr>(val));
+  errors++;
+}
+
+void then_before_fulfill()
+{
+  auto pp = IntPromise::create_promise();
+
+  pp.first.then(expect_value);
+
+  schedule_lambda([wp = std::move(pp.second)]() mutable {
+    IntPromise::fulfill(std::move(wp), 42);
+  });
+}
+
+void fulfill_before_then()
+{
+  auto pp = IntPromise::create_promise();
+
+  IntPromise::fulfill(std::move(pp.second), 42);
+
+  schedule_lambda([rp = std::move(pp.first)]() mutable {
+    rp.then(expect_value);
+  });
+}
+
+void race()
+{
+  auto pp = IntPromise::create_promise();
+
+  schedule_lambda([wp = std::move(pp.second)]() mutable {
+    IntPromise::fulfill(std::move(wp), 42);
+  });
+  schedule_lambda([rp = std::move(pp.first)]() mutable {
+    rp.then(expect_value);
+  });
+}
+
+void no_reader()
+{
+  auto pp = IntPromise::create_promise();
+  auto wp = std::move(pp.second);
+
+  schedule_lambda([wp = std::move(wp)]() mutable {
+    IntPromise::fulfill(std::move(wp), 42);
+  });
+}
+
+void no_writer()
+{
+  auto pp = IntPromise::create_promise();
+
+  pp.first.then(expect_error);
+
+  schedule_lambda([wp = std::move(pp.second)]() {});
+}
+
+void smart_pointer()
+{
+  using P = InlinePromise<unique_ptr<int>>;
+  auto pp = P::create_promise();
+
+  // Too large to be stored inline.
+  std::array<size_t, 16> padding{};
+  pp.first.then([padding](P::Result a) {
+    check(std::holds_alternative<unique_ptr<int>>(a));
+    check(*std::get<unique_ptr<int>>(a) == 42);
+    check(padding[15] == 0);
+    values++;
+  });
+
+  schedule_lambda([wp = std::move(pp.second)]() mutable {
+    P::fulfill(std::move(wp), make_unique<int>(42));
+  });
+}
+
+void then_on_cown()
+{
+  auto* c = new Counter;
+
+  for (size_t i = 0; i < 4; i++)
+  {
+    auto pp = IntPromise::create_promise();
+    pp.first.then(c, [c](IntPromise::Result val) {
+      check(!c->busy);
+      c->busy = true;
+      c->count++;
+      yield();
+      c->busy = false;
+      expect_value(std::move(val));
+    });
+
+    schedule_lambda([wp = std::move(pp.second)]() mutable {
+      IntPromise::fulfill(std::move(wp), 42);
+    });
+
+    schedule_lambda(c, [c]() {
+      check(!c->busy);
+      c->busy = true;
+      yield();
+      c->busy = false;
+    });
+  }
+
+  Cown::release(ThreadAlloc::get(), c);
+}
+
+int main(int argc, char** argv)
+{
+  SystematicTestHarness harness(argc, argv);
+
+  harness.run(then_before_fulfill);
+  harness.run(fulfill_before_then);
+  harness.run(race);
+  harness.run(no_reader);
+  harness.run(no_writer);
+  harness.run(smart_pointer);
+  harness.run(then_on_cown);
+
+  // Each test is run once per seed.
+  size_t runs = harness.seed_upper - harness.seed_lower;
+  check(values == runs * 8);
+  check(errors == runs);
+
+  return 0;
+}
@@ -0,0 +1,199 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Checks that every behaviour on a pinned cown runs on the same scheduler
+ * thread, whether it is scheduled from that thread, from another scheduler
+ * thread, or with other cowns, while the other threads are stealing work.
+ * Also checks that the behaviours on a pinned cown run in the order they were
+ * sent, whether or not they require other cowns.
+ */
+
+#include <test/harness.h>
+
+static constexpr size_t ROUNDS = 20;
+static constexpr size_t FREE_CELLS = 4;
+static constexpr size_t ORDERED = 10;
+
+static std::atomic<size_t> runs = 0;
+
+struct Cell : public VCown<Cell>
+{
+  void* thread = nullptr;
+  size_t next_step = 0;
+
+  /**
+   * Checks that this cell is running on the same thread as before.
+   */
+  void check_thread()
+  {
+    void* t = Scheduler::local();
+    check(t != nullptr);
+    if (thread == nullptr)
+      thread = t;
+    check(thread == t);
+    runs++;
+  }
+};
+
+static std::vector<Cell*> free_cells;
+
+// The free cells are released when the last chain of Touches ends.
+static std::atomic<size_t> chains = 0;
+
+struct Touch : public VBehaviour<Touch>
+{
+  Cell* cell;
+  size_t rounds;
+
+  Touch(Cell* cell, size_t rounds) : cell(cell), rounds(rounds) {}
+
+  void f();
+};
+
+struct Pair : public VBehaviour<Pair>
+{
+  Cell* cell;
+  Cell* other;
+
+  Pair(Cell* cell, Cell* other) : cell(cell), other(other) {}
+
+  void f()
+  {
+    cell->check_thread();
+  }
+};
+
+/**
+ * Sends the next Touch to a pinned cell, from whichever thread runs a free
+ * cell.
+ */
+struct Poke : public VBehaviour<Poke>
+{
+  Cell* cell;
+  size_t rounds;
+
+  Poke(Cell* cell, size_t rounds) : cell(cell), rounds(rounds) {}
+
+  void f()
+  {
+    Cown::schedule<Touch, YesTransfer>(cell, cell, rounds);
+  }
+};
+
+void Touch::f()
+{
+  cell->check_thread();
+  if (rounds == 0)
+  {
+    if (--chains == 0)
+    {
+      for (auto* c : free_cells)
+        Cown::release(ThreadAlloc::get(), c);
+    }
+    return;
+  }
+
+  auto* other = free_cells[rounds % free_cells.size()];
+  Cown* both[2] = {cell, other};
+  Cown::schedule<Pair>(2, both, cell, other);
+
+  Cown::acquire(cell);
+  Cown::schedule<Poke>(other, cell, rounds - 1);
+}
+
+/**
+ * The `step`th behaviour sent to a pinned cell by `Order`.
+ */
+struct Step : public VBehaviour<Step>
+{
+  Cell* cell;
+  size_t step;
+
+  Step(Cell* cell, size_t step) : cell(cell), step(step) {}
+
+  void f()
+  {
+    cell->check_thread();
+    check(cell->next_step == step);
+    cell->next_step++;
+  }
+};
+
+/**
+ * Runs on `other`, and so keeps it busy while it sends Steps that require it
+ * and a pinned cell, each followed by one that only requires the pinned cell.
+ * The later Steps must not overtake the earlier ones.
+ */
+struct Order : public VBehaviour<Order>
+{
+  Cell* other;
+  Cell* cell;
+
+  Order(Cell* other, Cell* cell) : other(other), cell(cell) {}
+
+  void f()
+  {
+    for (size_t i = 0; i < ORDERED; i++)
+    {
+      Cown* both[2] = {other, cell};
+      Cown::schedule<Step>(2, both, cell, 2 * i);
+      Cown::schedule<Step>(cell, cell, (2 * i) + 1);
+    }
+    Cown::release(ThreadAlloc::get(), cell);
+  }
+};
+
+/**
+ * Pins a new cown to the thread running this behaviour.
+ */
+struct Spawn : public VBehaviour<Spawn>
+{
+  void f()
+  {
+    auto* cell = new Cell;
+    cell->pin();
+    cell->check_thread();
+    Cown::schedule<Touch, YesTransfer>(cell, cell, ROUNDS);
+  }
+};
+
+void test_pinned(size_t cores)
+{
+  free_cells.clear();
+  chains = cores + FREE_CELLS;
+
+  for (size_t i = 0; i < FREE_CELLS; i++)
+    free_cells.push_back(new Cell);
+
+  for (auto* cell : free_cells)
+    Cown::schedule<Spawn>(cell);
+
+  for (size_t i = 0; i < cores; i++)
+  {
+    auto* cell = new Cell;
+    cell->pin(i);
+    Cown::schedule<Touch, YesTransfer>(cell, cell, ROUNDS);
+  }
+
+  auto* other = new Cell;
+  auto* cell = new Cell;
+  cell->pin(cores - 1);
+  Cown::schedule<Order, YesTransfer>(other, other, cell);
+}
+
+int main(int argc, char** argv)
+{
+  SystematicTestHarness harness(argc, argv);
+  harness.run(test_pinned, harness.cores);
+
+  // Each Spawn runs once, and starts a chain of Touches, as does each of the
+  // cells pinned up front.  Each Touch sends a Pair, and another Touch by way
+  // of a free cell, until its rounds run out.  Order sends two Steps a round.
+  auto seeds = harness.seed_upper - harness.seed_lower;
+  auto chains = harness.cores + FREE_CELLS;
+  check(
+    runs ==
+    seeds * (FREE_CELLS + chains * (2 * ROUNDS + 1) + (2 * ORDERED)));
+  return 0;
+}
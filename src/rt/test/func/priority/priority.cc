@@ -0,0 +1,68 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Checks that high priority cowns that always have work do not starve the
+ * normal priority cowns, see `Core::dequeue`.
+ */
+
+#include <test/harness.h>
+
+static constexpr size_t HIGH_COWNS = 4;
+static constexpr size_t NORMAL_COWNS = 4;
+
+static std::atomic<size_t> waiting = 0;
+
+struct Cell : public VCown<Cell>
+{};
+
+/**
+ * Keeps its cell scheduled until all of the normal cowns have run.
+ */
+struct Spin : public VBehaviour<Spin>
+{
+  Cell* cell;
+
+  Spin(Cell* cell) : cell(cell) {}
+
+  void f()
+  {
+    if (waiting != 0)
+      Cown::schedule<Spin>(cell, cell);
+  }
+};
+
+struct Finish : public VBehaviour<Finish>
+{
+  void f()
+  {
+    check(waiting > 0);
+    waiting--;
+  }
+};
+
+void test_starvation()
+{
+  waiting = NORMAL_COWNS;
+
+  for (size_t i = 0; i < HIGH_COWNS; i++)
+  {
+    auto* cell = new Cell;
+    cell->set_priority(Priority::High);
+    Cown::schedule<Spin, YesTransfer>(cell, cell);
+  }
+
+  for (size_t i = 0; i < NORMAL_COWNS; i++)
+  {
+    auto* cell = new Cell;
+    Cown::schedule<Finish, YesTransfer>(cell);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  SystematicTestHarness harness(argc, argv);
+  harness.run(test_starvation);
+  check(waiting == 0);
+  return 0;
+}
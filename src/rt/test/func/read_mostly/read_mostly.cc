@@ -0,0 +1,95 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Checks that writes to a read-mostly cown, which counts its readers on a
+ * line per core, still wait for every reader.
+ *
+ * Several clients each run rounds of read-only behaviours on a shared table,
+ * alone and together with the client's own log, followed by a write.  The
+ * clients run their rounds from their own cowns, so the readers are added and
+ * removed on different scheduler threads.
+ */
+
+#include <cpp/when.h>
+#include <test/harness.h>
+
+using namespace verona::cpp;
+
+static constexpr size_t CLIENTS = 4;
+static constexpr size_t ROUNDS = 10;
+static constexpr size_t READS = 4;
+
+struct Table
+{
+  // The read-only behaviours that are running.
+  mutable std::atomic<size_t> readers = 0;
+  size_t version = 0;
+
+  ~Table()
+  {
+    check(version == CLIENTS * ROUNDS);
+  }
+};
+
+struct Log
+{
+  size_t reads = 0;
+
+  ~Log()
+  {
+    check(reads == ROUNDS);
+  }
+};
+
+void read_table(acquired_cown<const Table>& table)
+{
+  table->readers++;
+  yield();
+  check(table->version <= CLIENTS * ROUNDS);
+  table->readers--;
+}
+
+void client_round(cown_ptr<Table> table, cown_ptr<Log> log, size_t left)
+{
+  for (size_t i = 0; i < READS; i++)
+    when(read(table)) << [](acquired_cown<const Table> table) {
+      read_table(table);
+    };
+
+  when(read(table), log) <<
+    [](acquired_cown<const Table> table, acquired_cown<Log> log) {
+      read_table(table);
+      log->reads++;
+    };
+
+  when(table) << [](acquired_cown<Table> table) {
+    check(table->readers == 0);
+    table->version++;
+  };
+
+  if (left > 1)
+    when(log) << [table, log, left](acquired_cown<Log>) {
+      client_round(table, log, left - 1);
+    };
+}
+
+void test_read_mostly()
+{
+  auto table = make_read_mostly_cown<Table>();
+
+  for (size_t i = 0; i < CLIENTS; i++)
+  {
+    auto log = make_cown<Log>();
+    when(log) << [table, log](acquired_cown<Log>) {
+      client_round(table, log, ROUNDS);
+    };
+  }
+}
+
+int main(int argc, char** argv)
+{
+  SystematicTestHarness harness(argc, argv);
+  harness.run(test_read_mostly);
+  return 0;
+}
@@ -0,0 +1,139 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * Checks that the behaviours of a `Cown::Batch` all run, in the order they
+ * were added, when several producers send batches to the same cown alongside
+ * single behaviours and read-only batches, and that a batch that is not sent
+ * is sent when it is destroyed.
+ */
+
+#include <test/harness.h>
+
+static constexpr size_t PRODUCERS = 4;
+static constexpr size_t ROUNDS = 8;
+static constexpr size_t BATCH = 5;
+// The behaviours scheduled on the counter by each round of a producer.
+static constexpr size_t PER_ROUND = BATCH + 2;
+
+struct Counter : public VCown<Counter>
+{
+  // The last sequence number run from each producer.
+  size_t last[PRODUCERS] = {};
+  size_t total = 0;
+
+  ~Counter()
+  {
+    check(total == PRODUCERS * ROUNDS * PER_ROUND);
+  }
+};
+
+struct Count : public VBehaviour<Count>
+{
+  Counter* counter;
+  size_t producer;
+  size_t seq;
+
+  Count(Counter* counter, size_t producer, size_t seq)
+  : counter(counter), producer(producer), seq(seq)
+  {}
+
+  void f()
+  {
+    check(counter->last[producer] + 1 == seq);
+    counter->last[producer] = seq;
+    counter->total++;
+  }
+};
+
+struct Look : public VBehaviour<Look>
+{
+  Counter* counter;
+
+  Look(Counter* counter) : counter(counter) {}
+
+  void f()
+  {
+    check(counter->total <= PRODUCERS * ROUNDS * PER_ROUND);
+  }
+};
+
+struct Producer : public VCown<Producer>
+{
+  Counter* counter;
+  size_t index;
+  size_t seq = 0;
+
+  Producer(Counter* counter, size_t index) : counter(counter), index(index)
+  {
+    Cown::acquire(counter);
+  }
+
+  void trace(ObjectStack& st) const
+  {
+    st.push(counter);
+  }
+};
+
+struct Produce : public VBehaviour<Produce>
+{
+  Producer* producer;
+  size_t left;
+
+  Produce(Producer* producer, size_t left) : producer(producer), left(left) {}
+
+  void f()
+  {
+    auto* counter = producer->counter;
+
+    Cown::Batch batch(counter);
+    for (size_t i = 0; i < BATCH; i++)
+      batch.add<Count>(counter, producer->index, ++producer->seq);
+    check(batch.size() == BATCH);
+    batch.send();
+    check(batch.size() == 0);
+
+    Cown::Batch reads(Request::read(counter));
+    for (size_t i = 0; i < BATCH; i++)
+      reads.add<Look>(counter);
+
+    // Behaviours scheduled after others were added still run before the
+    // batch is sent.
+    Cown::schedule<Count>(counter, counter, producer->index, ++producer->seq);
+    reads.send();
+
+    // Sending an empty batch does nothing.
+    reads.send();
+
+    // A batch that is destroyed before it is sent is sent then.
+    {
+      Cown::Batch unsent(counter);
+      unsent.add<Count>(counter, producer->index, ++producer->seq);
+    }
+
+    if (left > 1)
+      Cown::schedule<Produce>(producer, producer, left - 1);
+    else
+      Cown::release(ThreadAlloc::get(), producer);
+  }
+};
+
+void test_schedule_batch()
+{
+  auto* counter = new Counter;
+
+  for (size_t i = 0; i < PRODUCERS; i++)
+  {
+    auto* producer = new Producer(counter, i);
+    Cown::schedule<Produce>(producer, producer, ROUNDS);
+  }
+
+  Cown::release(ThreadAlloc::get(), counter);
+}
+
+int main(int argc, char** argv)
+{
+  SystematicTestHarness harness(argc, argv);
+  harness.run(test_schedule_batch);
+  return 0;
+}
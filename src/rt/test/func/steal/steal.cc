@@ -44,9 +44,25 @@ void basic_test(size_t cores)
   }
 }
 
+void burst_test(size_t cores)
+{
+  // Many more runners than cores, all scheduled from one thread, so that the
+  // other threads start with nothing and steal from a deep queue.
+  for (size_t i = 0; i < cores * 16; i++)
+  {
+    schedule_run(3);
+  }
+}
+
 int main(int argc, char** argv)
 {
   SystematicTestHarness harness(argc, argv);
   harness.run(basic_test, harness.cores);
+
+  // Again, taking up to half of a queue in each steal.
+  Scheduler::set_steal_batch(8);
+  harness.run(basic_test, harness.cores);
+  harness.run(burst_test, harness.cores);
+  Scheduler::set_steal_batch(1);
   return 0;
 }
@@ -17,7 +17,6 @@
 #  include <thread>
 #endif
 
-#include "../ds/asymlock.h"
 #include "ds/morebits.h"
 
 #include <iomanip>
@@ -39,27 +38,38 @@ namespace Logging
   static constexpr bool flight_recorder = false;
 #endif
 
-  struct Header
+  /**
+   * An entry in a thread's flight recorder.  A log line is recorded as one
+   * item per value, followed by a header, so that the log can be walked
+   * backwards from its most recent line.
+   *
+   * The fields are atomic so that the log can be dumped while its thread is
+   * still writing to it, see `LocalLog`.
+   */
+  struct Entry
   {
-    size_t time;
-    size_t items;
-  };
-
-  struct Item
-  {
-    size_t value;
-    std::ostream& (*pp)(std::ostream&, size_t const&);
-  };
-
-  union Entry
-  {
-    Header header;
-    Item item;
+    // For an item, the value.  For a header, the time of the line.
+    std::atomic<size_t> value;
+    // For an item, the function that prints the value.  For a header, the
+    // number of items in the line.
+    std::atomic<size_t> printer;
   };
 
   // Filled in later by the scheduler thread
   std::string get_systematic_id();
 
+  /**
+   * A thread's flight recorder: a ring buffer of its most recent log lines.
+   *
+   * Logging records the raw values, and the function to print each of them,
+   * and only formats them when the log is dumped.  Only the owning thread
+   * writes to the log, and it never waits for a reader.  `working_index`
+   * counts all of the entries ever written, and is advanced before an entry
+   * is overwritten, and `index` publishes each completed line.  A dump reads
+   * lines backwards from `index`, then rereads `working_index` to discard any
+   * line that may have been overwritten while it was being read, so the
+   * thread does not need to be stopped.
+   */
   class LocalLog : public snmalloc::Pooled<LocalLog>
   {
   private:
@@ -67,26 +77,32 @@ namespace Logging
     friend class SysLog;
 
 #ifdef USE_FLIGHT_RECORDER
-    static constexpr size_t size =
-      (1 << 18) - 3 - (sizeof(verona::rt::AsymmetricLock) / 8);
+    static constexpr size_t size = 1 << 17;
 #else
     static constexpr size_t size = 1;
 #endif
-    size_t index;
-    size_t working_index;
-    std::string systematic_id = "";
-    verona::rt::AsymmetricLock alock;
+    static_assert(snmalloc::bits::is_pow2(size));
+
+    std::atomic<size_t> working_index{0};
+    std::atomic<size_t> index{0};
+
+    // The position of the next line to dump, only used while dumping.
+    size_t dump_index = 0;
+
+    // Formatted on the first line after `reset_id`, rather than per line.
+    // This is a fixed buffer of atomics, rather than a `std::string`, as a
+    // dump may read it while the owning thread replaces it.
+    static constexpr size_t id_size = 32;
+    std::atomic<char> systematic_id[id_size] = {};
+    bool has_systematic_id = false;
+
+    // The most items of a line that are printed by a dump.
+    static constexpr size_t max_items = 64;
 
     Entry log[size];
 
   public:
-    LocalLog()
-    {
-      if constexpr (flight_recorder)
-      {
-        reset();
-      }
-    }
+    LocalLog() = default;
 
   private:
     static size_t get_start()
@@ -95,84 +111,130 @@ namespace Logging
       return start;
     }
 
+    void write(size_t value, size_t printer)
+    {
+      auto w = working_index.load(std::memory_order_relaxed);
+      working_index.store(w + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+
+      auto& entry = log[w % size];
+      entry.value.store(value, std::memory_order_relaxed);
+      entry.printer.store(printer, std::memory_order_relaxed);
+    }
+
     void add(size_t pp, size_t val)
     {
-      alock.internal_acquire();
-      working_index = verona::rt::bits::inc_mod(working_index, size);
-      log[working_index].header.time = val;
-      log[working_index].header.items = pp;
-      alock.internal_release();
+      write(val, pp);
     }
 
     void eject()
     {
-      alock.internal_acquire();
-      systematic_id = get_systematic_id();
-      working_index = verona::rt::bits::inc_mod(working_index, size);
-      log[working_index].header.time = snmalloc::Aal::tick() - get_start();
-      log[working_index].header.items = (working_index - index + size) % size;
-      index = working_index;
-      alock.internal_release();
+      if (!has_systematic_id)
+      {
+        set_id(get_systematic_id());
+        has_systematic_id = true;
+      }
+
+      auto items = working_index.load(std::memory_order_relaxed) -
+        index.load(std::memory_order_relaxed);
+      // Read the start first, as the first call sets it.
+      auto start = get_start();
+      write(snmalloc::Aal::tick() - start, items);
+      index.store(
+        working_index.load(std::memory_order_relaxed),
+        std::memory_order_release);
     }
 
-    void suspend_logging(bool external)
+    void reset_id()
     {
-      if (external)
-        alock.external_acquire();
+      has_systematic_id = false;
+    }
 
-      working_index = size - 1;
+    void set_id(const std::string& id)
+    {
+      auto length = snmalloc::bits::min<size_t>(id.size(), id_size - 1);
+      for (size_t i = 0; i < length; i++)
+        systematic_id[i].store(id[i], std::memory_order_relaxed);
+      systematic_id[length].store('\0', std::memory_order_relaxed);
     }
 
-    void resume_logging(bool external)
+    void print_id(std::ostream& o)
     {
-      if (external)
-        alock.external_release();
+      for (auto& c : systematic_id)
+      {
+        auto ch = c.load(std::memory_order_relaxed);
+        if (ch == '\0')
+          break;
+        o << ch;
+      }
+    }
 
-      reset();
+    /**
+     * Returns false if the line at `position`, which is `items` long, may
+     * have been overwritten since it was read.
+     */
+    bool still_valid(size_t position, size_t items)
+    {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      auto w = working_index.load(std::memory_order_relaxed);
+      return (position >= items) && (w <= position - items + size);
     }
 
-    void reset()
+    void start_dump()
     {
-      log[0].header.time = 0;
-      log[0].header.items = 0;
-      index = 0;
-      working_index = 0;
+      dump_index = index.load(std::memory_order_acquire);
     }
 
     bool peek_time(size_t& time)
     {
-      auto entry_size = log[index % size].header.items;
-
-      if (entry_size == 0)
+      if (dump_index == 0)
         return false;
 
-      if (working_index <= entry_size)
+      auto& header = log[(dump_index - 1) % size];
+      time = header.value.load(std::memory_order_relaxed);
+      auto items = header.printer.load(std::memory_order_relaxed);
+
+      if (!still_valid(dump_index - 1, items))
+      {
+        dump_index = 0;
         return false;
+      }
 
-      time = log[index % size].header.time;
       return true;
     }
 
     void pop_and_print(std::ostream& o)
     {
-      size_t time;
-      assert(peek_time(time));
-
-      size_t entry_size = log[index % size].header.items;
-
-      time = log[index % size].header.time;
-
-      o << systematic_id;
+      auto& header = log[(dump_index - 1) % size];
+      auto time = header.value.load(std::memory_order_relaxed);
+      auto items = header.printer.load(std::memory_order_relaxed);
+      auto start = dump_index - 1 - items;
+
+      std::pair<size_t, size_t> line[max_items];
+      auto count = snmalloc::bits::min<size_t>(items, max_items);
+      for (size_t n = 0; n < count; n++)
+      {
+        auto& entry = log[(start + n) % size];
+        line[n] = {entry.value.load(std::memory_order_relaxed),
+                   entry.printer.load(std::memory_order_relaxed)};
+      }
 
-      index = (index - entry_size + size) % size;
-      working_index = working_index - entry_size;
+      if (!still_valid(dump_index - 1, items))
+      {
+        dump_index = 0;
+        return;
+      }
+      dump_index = start;
 
-      for (size_t n = 1; n < entry_size; n++)
+      print_id(o);
+      for (size_t n = 0; n < count; n++)
       {
-        auto pp = log[(index + n) % size].item.pp;
-        size_t value = log[(index + n) % size].item.value;
-        (*pp)(o, value);
+        auto pp =
+          (std::ostream & (*)(std::ostream&, size_t const&)) line[n].second;
+        (*pp)(o, line[n].first);
       }
+      if (count < items)
+        o << " ... (" << (items - count) << " more items not shown)";
 
       o << " (" << time << ")" << std::endl;
     }
@@ -187,7 +249,11 @@ namespace Logging
 
     LocalLog* log = nullptr;
 #ifdef USE_FLIGHT_RECORDER
-    ThreadLocalLog() : log(LocalLogPool::acquire()) {}
+    ThreadLocalLog() : log(LocalLogPool::acquire())
+    {
+      // The log may have been used by a thread that has exited.
+      log->reset_id();
+    }
 
     ~ThreadLocalLog()
     {
@@ -202,6 +268,18 @@ namespace Logging
       return mine;
     }
 
+    /**
+     * Called when the identity of this thread, as given by
+     * `get_systematic_id`, changes.
+     */
+    static void reset_id()
+    {
+      if constexpr (flight_recorder)
+      {
+        get().log->reset_id();
+      }
+    }
+
     static void dump(std::ostream& o)
     {
       if constexpr (flight_recorder)
@@ -210,13 +288,11 @@ namespace Logging
 
         o << "THIS IS BACKWARDS COMPARED TO THE NORMAL LOG!" << std::endl;
 
-        // Set up all logs for dumping
+        // Lines logged from now on are not dumped.
         auto curr = LocalLogPool::iterate();
-        auto mine = get().log;
-
         while (curr != nullptr)
         {
-          curr->suspend_logging(curr != mine);
+          curr->start_dump();
           curr = LocalLogPool::iterate(curr);
         }
 
@@ -247,13 +323,6 @@ namespace Logging
           next->pop_and_print(o);
         }
 
-        curr = LocalLogPool::iterate();
-        while (curr != nullptr)
-        {
-          curr->resume_logging(curr != mine);
-          curr = LocalLogPool::iterate(curr);
-        }
-
         o.flush();
       }
     }
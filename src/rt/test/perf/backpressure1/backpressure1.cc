@@ -7,6 +7,10 @@
  * may be placed behind a chain of `Proxy` cowns to test backpressure
  * propagation.
  *
+ * With `--batch`, each `Send` sends that many messages at once.  Messages to a
+ * single cown, the first proxy or the only receiver, are sent as a
+ * `Cown::Batch`, with a single enqueue.
+ *
  * Without backpressure, the receivers would have their queues grow at a much
  * higher rate than they could process the messages. The muted proxies may also
  * experience similar queue growth if the backpressure is not corretly
@@ -26,6 +30,7 @@ struct Receiver;
 struct Proxy;
 static std::vector<Receiver*> receiver_set;
 static std::vector<Proxy*> proxy_chain;
+static size_t batch = 1;
 
 struct Receiver : public VCown<Receiver>
 {
@@ -121,9 +126,25 @@ struct Send : public VBehaviour<Send>
   void f()
   {
     if (proxy_chain.size() > 0)
-      Cown::schedule<Forward>(proxy_chain[0], proxy_chain[0]);
+    {
+      Cown::Batch b(proxy_chain[0]);
+      for (size_t i = 0; i < batch; i++)
+        b.add<Forward>(proxy_chain[0]);
+      b.send();
+    }
+    else if (receiver_set.size() == 1)
+    {
+      Cown::Batch b(receiver_set[0]);
+      for (size_t i = 0; i < batch; i++)
+        b.add<Receive>();
+      b.send();
+    }
     else
-      Cown::schedule<Receive>(receiver_set.size(), (Cown**)receiver_set.data());
+    {
+      for (size_t i = 0; i < batch; i++)
+        Cown::schedule<Receive>(
+          receiver_set.size(), (Cown**)receiver_set.data());
+    }
 
     if ((Sender::clk::now() - s->start) < s->duration)
       Cown::schedule<Send>(s, s);
@@ -139,9 +160,10 @@ int main(int argc, char** argv)
   auto receivers = opt.is<size_t>("--receivers", 1);
   auto proxies = opt.is<size_t>("--proxies", 0);
   auto duration = opt.is<size_t>("--duration", 10'000);
+  batch = std::max<size_t>(opt.is<size_t>("--batch", 1), 1);
   logger::cout() << "cores: " << cores << ", senders: " << senders
                  << ", receivers: " << receivers << ", duration: " << duration
-                 << "ms" << std::endl;
+                 << "ms, batch: " << batch << std::endl;
 
 #ifdef USE_SYSTEMATIC_TESTING
   Logging::enable_logging();
@@ -9,6 +9,9 @@
  *
  * A correct implementation of backpressure must ensure that the receivers make
  * progress despite requiring their muted senders to do so.
+ *
+ * With `--batch`, each `Send` sends the receiver that many messages as a
+ * `Cown::Batch`, with a single enqueue.
  */
 
 #include "test/log.h"
@@ -23,6 +26,8 @@ using timer = std::chrono::high_resolution_clock;
 
 struct Sender;
 
+static size_t batch = 1;
+
 struct Receiver : public VCown<Receiver>
 {
   std::vector<Sender*>& senders;
@@ -102,7 +107,10 @@ struct Send : public VBehaviour<Send>
 
   void f()
   {
-    Cown::schedule<Receive>(s->receiver, s->receiver);
+    Cown::Batch b(s->receiver);
+    for (size_t i = 0; i < batch; i++)
+      b.add<Receive>(s->receiver);
+    b.send();
 
     if ((timer::now() - s->start) < s->duration)
       Cown::schedule<Send>(s, s);
@@ -119,9 +127,11 @@ int main(int argc, char** argv)
   const auto senders = opt.is<size_t>("--senders", 100);
   const auto duration =
     std::chrono::milliseconds(opt.is<size_t>("--duration", 10'000));
+  batch = std::max<size_t>(opt.is<size_t>("--batch", 1), 1);
 
   logger::cout() << "cores: " << cores << ", senders: " << senders
-                 << ", duration: " << duration.count() << "ms" << std::endl;
+                 << ", duration: " << duration.count()
+                 << "ms, batch: " << batch << std::endl;
 
 #ifdef USE_SYSTEMATIC_TESTING
   Logging::enable_logging();
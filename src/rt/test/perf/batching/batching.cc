@@ -0,0 +1,169 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * This benchmark is for measuring how a cown's message batching affects the
+ * latency of other cowns.
+ *
+ * A `Driver` cown repeatedly sends a burst of short behaviours to each of a
+ * set of short cowns, and a burst of long behaviours, which spin for
+ * `--long_usec`, to each of a set of long cowns.  Each short behaviour records
+ * the time between being sent and starting to run.  When a long cown is run
+ * with a large batch, the short cowns behind it in the same scheduler queue
+ * wait for the whole batch, which shows up in the tail of the short behaviours'
+ * latency.
+ *
+ * `--batch_limit` and `--batch_cycles` configure the scheduler's batching, see
+ * `ThreadPool::set_batch_limit`.  The benchmark reports the throughput, and the
+ * median, 99th percentile and maximum latency of the short behaviours.
+ */
+
+#include "test/log.h"
+#include "test/opt.h"
+#include "verona.h"
+
+#include <algorithm>
+#include <test/harness.h>
+
+namespace sn = snmalloc;
+namespace rt = verona::rt;
+
+struct Worker : public VCown<Worker>
+{
+  std::vector<uint64_t> latencies;
+};
+
+static std::vector<Worker*> short_cowns;
+static std::vector<Worker*> long_cowns;
+static std::vector<rt::Cown*> all_cowns;
+static size_t burst = 0;
+static size_t long_usec = 0;
+static size_t behaviours = 0;
+static uint64_t start = 0;
+
+struct Short : public VBehaviour<Short>
+{
+  Worker* worker;
+  uint64_t sent;
+
+  Short(Worker* worker) : worker(worker), sent(sn::Aal::tick()) {}
+
+  void f()
+  {
+    worker->latencies.push_back(sn::Aal::tick() - sent);
+  }
+};
+
+struct Long : public VBehaviour<Long>
+{
+  void f()
+  {
+    busy_loop(long_usec);
+  }
+};
+
+/**
+ * Runs once all of the workers have finished their bursts.
+ */
+struct Report : public VBehaviour<Report>
+{
+  void f()
+  {
+    auto end = sn::Aal::tick();
+
+    std::vector<uint64_t> latencies;
+    for (auto* w : short_cowns)
+      latencies.insert(
+        latencies.end(), w->latencies.begin(), w->latencies.end());
+    std::sort(latencies.begin(), latencies.end());
+    check(!latencies.empty());
+
+    logger::cout() << "throughput: "
+                   << (behaviours * 1'000'000) / ((end - start) + 1)
+                   << " behaviours per million cycles" << std::endl;
+    logger::cout() << "short latency (cycles): p50 "
+                   << latencies[latencies.size() / 2] << ", p99 "
+                   << latencies[(latencies.size() * 99) / 100] << ", max "
+                   << latencies.back() << std::endl;
+
+    auto& alloc = sn::ThreadAlloc::get();
+    for (auto* c : all_cowns)
+      rt::Cown::release(alloc, c);
+  }
+};
+
+struct Driver : public VCown<Driver>
+{
+  size_t rounds;
+
+  Driver(size_t rounds) : rounds(rounds) {}
+};
+
+struct Round : public VBehaviour<Round>
+{
+  Driver* driver;
+
+  Round(Driver* driver) : driver(driver) {}
+
+  void f()
+  {
+    for (size_t i = 0; i < burst; i++)
+    {
+      for (auto* w : long_cowns)
+        rt::Cown::schedule<Long>(w);
+      for (auto* w : short_cowns)
+        rt::Cown::schedule<Short>(w, w);
+    }
+
+    if (--driver->rounds != 0)
+    {
+      rt::Cown::schedule<Round>(driver, driver);
+      return;
+    }
+
+    rt::Cown::schedule<Report>(all_cowns.size(), all_cowns.data());
+    rt::Cown::release(sn::ThreadAlloc::get(), driver);
+  }
+};
+
+int main(int argc, char** argv)
+{
+  opt::Opt opt(argc, argv);
+  const auto cores = opt.is<size_t>("--cores", 4);
+  const auto shorts = opt.is<size_t>("--short_cowns", 16);
+  const auto longs = opt.is<size_t>("--long_cowns", 2);
+  const auto rounds = opt.is<size_t>("--rounds", 20);
+  burst = opt.is<size_t>("--burst", 100);
+  long_usec = opt.is<size_t>("--long_usec", 20);
+  const auto batch_limit = opt.is<size_t>("--batch_limit", 100);
+  const auto batch_cycles = opt.is<size_t>("--batch_cycles", 100'000);
+
+  logger::cout() << "cores: " << cores << ", short cowns: " << shorts
+                 << ", long cowns: " << longs << ", burst: " << burst
+                 << ", long_usec: " << long_usec
+                 << ", batch_limit: " << batch_limit
+                 << ", batch_cycles: " << batch_cycles << std::endl;
+
+  auto& alloc = sn::ThreadAlloc::get();
+  auto& sched = rt::Scheduler::get();
+  sched.set_batch_limit(batch_limit, batch_cycles);
+  sched.init(cores);
+
+  for (size_t i = 0; i < shorts; i++)
+    short_cowns.push_back(new (alloc) Worker);
+  for (size_t i = 0; i < longs; i++)
+    long_cowns.push_back(new (alloc) Worker);
+
+  for (auto* w : short_cowns)
+    all_cowns.push_back(w);
+  for (auto* w : long_cowns)
+    all_cowns.push_back(w);
+
+  behaviours = rounds * burst * all_cowns.size();
+  auto* driver = new (alloc) Driver(rounds);
+  rt::Cown::schedule<Round>(driver, driver);
+
+  start = sn::Aal::tick();
+  sched.run();
+  return 0;
+}
@@ -0,0 +1,121 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * This benchmark compares a coroutine behaviour, see `async_behaviour`, with
+ * the equivalent chain of `when` callbacks.
+ *
+ * Each of `--workflows` workflows takes `--steps` steps.  Each step increments
+ * one of `--cells` cells, chosen at random, and the state of the workflow.
+ * The callback version schedules each step from the closure of the last,
+ * which carries the workflow's state, and the coroutine version awaits each
+ * step in a loop, with the state in its frame.  The benchmark runs both, and
+ * reports the time each took.
+ */
+
+#include "test/log.h"
+#include "test/opt.h"
+#include "test/xoroshiro.h"
+
+#include <chrono>
+#include <cpp/coroutine.h>
+#include <test/harness.h>
+
+using namespace verona::cpp;
+using timer = std::chrono::high_resolution_clock;
+
+struct Cell
+{
+  uint64_t count = 0;
+};
+
+struct Workflow
+{
+  xoroshiro::p128r32 rng;
+  uint64_t sum = 0;
+  size_t taken = 0;
+
+  Workflow(size_t seed) : rng(seed) {}
+};
+
+static std::vector<cown_ptr<Cell>> cells;
+static size_t steps = 0;
+static size_t workflows = 0;
+static std::atomic<size_t> finished = 0;
+static std::atomic<size_t> total_steps = 0;
+
+/**
+ * Called at the end of each workflow.  The last one releases the cells.
+ */
+void finish(const Workflow& w)
+{
+  total_steps += w.taken;
+  if (++finished == workflows)
+    cells.clear();
+}
+
+void callback_step(Workflow w)
+{
+  auto& cell = cells[w.rng.next() % cells.size()];
+  when(cell) << [w = std::move(w)](acquired_cown<Cell> c) mutable {
+    w.sum += ++c->count;
+    if (++w.taken != steps)
+      callback_step(std::move(w));
+    else
+      finish(w);
+  };
+}
+
+async_behaviour coroutine_workflow(size_t seed)
+{
+  Workflow w(seed);
+  while (w.taken != steps)
+  {
+    auto c = co_await when(cells[w.rng.next() % cells.size()]);
+    w.sum += ++c->count;
+    w.taken++;
+  }
+  finish(w);
+}
+
+template<typename F>
+void run(const char* name, size_t cores, size_t count, F f)
+{
+  auto& sched = Scheduler::get();
+  sched.init(cores);
+
+  for (size_t i = 0; i < count; i++)
+    cells.push_back(make_cown<Cell>());
+
+  finished = 0;
+  total_steps = 0;
+  auto start = timer::now();
+  for (size_t i = 0; i < workflows; i++)
+    f(i + 1);
+  sched.run();
+  auto t = std::chrono::duration_cast<std::chrono::milliseconds>(
+    timer::now() - start);
+
+  check(total_steps == workflows * steps);
+  logger::cout() << name << ": " << t.count() << "ms" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  opt::Opt opt(argc, argv);
+  const auto cores = opt.is<size_t>("--cores", 4);
+  workflows = opt.is<size_t>("--workflows", 1000);
+  const auto count = opt.is<size_t>("--cells", 100);
+  steps = opt.is<size_t>("--steps", 1000);
+
+  logger::cout() << "cores: " << cores << ", workflows: " << workflows
+                 << ", cells: " << count << ", steps: " << steps << std::endl;
+
+  run("callbacks", cores, count, [](size_t seed) {
+    callback_step(Workflow(seed));
+  });
+  run("coroutines", cores, count, [](size_t seed) {
+    coroutine_workflow(seed);
+  });
+  return 0;
+}
@@ -8,6 +8,8 @@ inline size_t NUM_PHILOSOPHERS = 50;
 inline bool OPTIMAL_ORDER = false;
 inline size_t WORK_USEC = 1000;
 inline bool MANUAL_LOCK_ORDER = false;
+inline size_t INLINE_DEPTH = 0;
+inline size_t INLINE_COUNT = 16;
 
 inline bool process_args(SystematicTestHarness& harness)
 {
@@ -19,6 +21,9 @@ inline bool process_args(SystematicTestHarness& harness)
 
   MANUAL_LOCK_ORDER = harness.opt.has("--manual_lock_order");
 
+  INLINE_DEPTH = harness.opt.is<size_t>("--inline_depth", INLINE_DEPTH);
+  INLINE_COUNT = harness.opt.is<size_t>("--inline_count", INLINE_COUNT);
+
   if (NUM_PHILOSOPHERS < 2)
   {
     std::cerr << "--num_philosophers must be at least 2" << std::endl;
@@ -99,6 +99,7 @@ void test1()
 
 int verona_main(SystematicTestHarness& harness)
 {
+  verona::rt::Scheduler::set_inline_budget(INLINE_DEPTH, INLINE_COUNT);
   harness.run(test1);
 
   return 0;
@@ -0,0 +1,157 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * This benchmark is for measuring contention between the threads that write
+ * the fields of a shared cown, see the layout of `Cown`.
+ *
+ * One `Sender` cown per core runs `--rounds` rounds.  In each round it sends
+ * every one of `--counters` `Counter` cowns `--reads` read-only behaviours
+ * and then one behaviour that writes to it.  So the senders on every core
+ * write the back of each counter's message queue and its reference counts,
+ * the thread running a counter writes the front of its queue, and the
+ * read-only behaviours, which run in parallel on several cores, write its
+ * read count.
+ *
+ * `perf-con-false_sharing_compact` is built with `USE_COMPACT_COWNS`, which
+ * packs these fields onto shared cache lines.  The benchmark reports the size
+ * of each counter and the throughput, to compare the two layouts.
+ */
+
+#include "test/log.h"
+#include "test/opt.h"
+#include "verona.h"
+
+#include <test/harness.h>
+
+namespace sn = snmalloc;
+namespace rt = verona::rt;
+
+struct Counter : public VCown<Counter>
+{
+  uint64_t writes = 0;
+};
+
+static std::vector<rt::Cown*> counters;
+static std::atomic<size_t> senders_left = 0;
+static size_t senders = 0;
+static size_t rounds = 0;
+static size_t reads = 0;
+static size_t behaviours = 0;
+static uint64_t start = 0;
+
+struct Read : public VBehaviour<Read>
+{
+  Counter* counter;
+
+  Read(Counter* counter) : counter(counter) {}
+
+  void f()
+  {
+    check(counter->writes <= senders * rounds);
+  }
+};
+
+struct Write : public VBehaviour<Write>
+{
+  Counter* counter;
+
+  Write(Counter* counter) : counter(counter) {}
+
+  void f()
+  {
+    counter->writes++;
+  }
+};
+
+/**
+ * Runs once every sender has finished, and so after every other behaviour on
+ * the counters.
+ */
+struct Report : public VBehaviour<Report>
+{
+  void f()
+  {
+    auto end = sn::Aal::tick();
+
+    for (auto* c : counters)
+      check(((Counter*)c)->writes == senders * rounds);
+
+    logger::cout() << "counter size: " << rt::vsizeof<Counter> << " bytes"
+                   << std::endl;
+    logger::cout() << "throughput: "
+                   << (behaviours * 1'000'000) / ((end - start) + 1)
+                   << " behaviours per million cycles" << std::endl;
+
+    auto& alloc = sn::ThreadAlloc::get();
+    for (auto* c : counters)
+      rt::Cown::release(alloc, c);
+  }
+};
+
+struct Sender : public VCown<Sender>
+{
+  size_t left = rounds;
+};
+
+struct Round : public VBehaviour<Round>
+{
+  Sender* sender;
+
+  Round(Sender* sender) : sender(sender) {}
+
+  void f()
+  {
+    for (auto* c : counters)
+    {
+      auto* counter = (Counter*)c;
+      auto request = rt::Request::read(counter);
+      for (size_t i = 0; i < reads; i++)
+        rt::Cown::schedule<Read>(1, &request, counter);
+      rt::Cown::schedule<Write>(counter, counter);
+    }
+
+    if (--sender->left != 0)
+    {
+      rt::Cown::schedule<Round>(sender, sender);
+      return;
+    }
+
+    rt::Cown::release(sn::ThreadAlloc::get(), sender);
+    if (--senders_left == 0)
+      rt::Cown::schedule<Report>(counters.size(), counters.data());
+  }
+};
+
+int main(int argc, char** argv)
+{
+  opt::Opt opt(argc, argv);
+  const auto cores = opt.is<size_t>("--cores", 4);
+  const auto count = opt.is<size_t>("--counters", 4);
+  rounds = opt.is<size_t>("--rounds", 1000);
+  reads = opt.is<size_t>("--reads", 4);
+
+  logger::cout() << "cores: " << cores << ", counters: " << count
+                 << ", rounds: " << rounds << ", reads: " << reads
+                 << std::endl;
+
+  auto& alloc = sn::ThreadAlloc::get();
+  auto& sched = rt::Scheduler::get();
+  sched.init(cores);
+
+  for (size_t i = 0; i < count; i++)
+    counters.push_back(new (alloc) Counter);
+
+  behaviours = cores * rounds * count * (reads + 1);
+  senders = cores;
+  senders_left = cores;
+  for (size_t i = 0; i < cores; i++)
+  {
+    auto* sender = new (alloc) Sender;
+    rt::Cown::schedule<Round>(sender, sender);
+  }
+
+  start = sn::Aal::tick();
+  sched.run();
+  return 0;
+}
@@ -0,0 +1,144 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * This benchmark is for measuring the cost of sending multi-messages to
+ * contended cowns.
+ *
+ * There is a small set of shared cowns, and a number of clients.  Each client
+ * runs a chain of behaviours, each on a random selection of between
+ * `--min_width` and `--max_width` of the shared cowns, and each behaviour
+ * schedules the next behaviour of its client.  The clients therefore keep
+ * sending multi-messages to overlapping sets of cowns from all scheduler
+ * threads at once.
+ *
+ * The benchmark is repeated for 1, 2, 4, ... up to `--cores` threads, and
+ * reports the average time per behaviour.
+ */
+
+#include "test/log.h"
+#include "test/opt.h"
+#include "test/xoroshiro.h"
+#include "verona.h"
+
+#include <chrono>
+#include <test/harness.h>
+
+namespace sn = snmalloc;
+namespace rt = verona::rt;
+
+struct Cell : public VCown<Cell>
+{};
+
+static Cell** cells = nullptr;
+static size_t cells_count = 0;
+static size_t min_width = 0;
+static size_t max_width = 0;
+static std::atomic<size_t> clients_running{0};
+
+struct Client
+{
+  size_t remaining;
+  xoroshiro::p128r32 rng;
+
+  Client(size_t remaining, size_t seed) : remaining(remaining), rng(seed) {}
+};
+
+struct Hammer : public VBehaviour<Hammer>
+{
+  Client* client;
+
+  Hammer(Client* client) : client(client) {}
+
+  static void send(Client* client)
+  {
+    Cell* targets[64];
+    auto width = min_width + (client->rng.next() % (max_width - min_width + 1));
+
+    // Pick `width` distinct cells.
+    size_t picked = 0;
+    while (picked < width)
+    {
+      auto c = cells[client->rng.next() % cells_count];
+      bool duplicate = false;
+      for (size_t i = 0; i < picked; i++)
+        duplicate |= (targets[i] == c);
+
+      if (!duplicate)
+        targets[picked++] = c;
+    }
+
+    rt::Cown::schedule<Hammer>(width, (rt::Cown**)targets, client);
+  }
+
+  void f()
+  {
+    if (--client->remaining != 0)
+    {
+      send(client);
+      return;
+    }
+
+    delete client;
+    if (clients_running.fetch_sub(1) != 1)
+      return;
+
+    // The last client to finish drops the cells.
+    auto& alloc = sn::ThreadAlloc::get();
+    for (size_t i = 0; i < cells_count; i++)
+      rt::Cown::release(alloc, cells[i]);
+  }
+};
+
+int main(int argc, char** argv)
+{
+  opt::Opt opt(argc, argv);
+  const auto seed = opt.is<size_t>("--seed", 5489);
+  const auto cores = opt.is<size_t>("--cores", 4);
+  cells_count = opt.is<size_t>("--cowns", 16);
+  const auto clients = opt.is<size_t>("--clients", 64);
+  const auto behaviours = opt.is<size_t>("--behaviours", 1000);
+  min_width = opt.is<size_t>("--min_width", 2);
+  max_width = opt.is<size_t>("--max_width", 8);
+  check(clients > 0);
+  check(min_width >= 1);
+  check(min_width <= max_width);
+  check(max_width <= cells_count);
+  check(max_width <= 64);
+
+  logger::cout() << "cowns: " << cells_count << ", clients: " << clients
+                 << ", behaviours: " << behaviours << ", width: " << min_width
+                 << "-" << max_width << std::endl;
+
+  auto& alloc = sn::ThreadAlloc::get();
+#ifdef USE_SYSTEMATIC_TESTING
+  Logging::enable_logging();
+  Systematic::set_seed(seed);
+#endif
+
+  cells = (Cell**)alloc.alloc(cells_count * sizeof(Cell*));
+
+  auto& sched = rt::Scheduler::get();
+  for (size_t threads = 1; threads <= cores; threads *= 2)
+  {
+    sched.init(threads);
+
+    for (size_t i = 0; i < cells_count; i++)
+      cells[i] = new (alloc) Cell;
+
+    clients_running = clients;
+    for (size_t i = 0; i < clients; i++)
+      Hammer::send(new Client(behaviours, seed + i));
+
+    auto start = sn::Aal::tick();
+    sched.run();
+    auto end = sn::Aal::tick();
+
+    logger::cout() << "threads: " << threads << ", time per behaviour: "
+                   << (end - start) / (clients * behaviours) << std::endl;
+  }
+
+  alloc.dealloc(cells, cells_count * sizeof(Cell*));
+  snmalloc::debug_check_empty<snmalloc::Alloc::Config>();
+  return 0;
+}
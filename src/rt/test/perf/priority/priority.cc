@@ -0,0 +1,173 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * This benchmark is for measuring the latency of a high priority cown under
+ * a saturating background load.
+ *
+ * A set of `--background` worker cowns each keep running behaviours that spin
+ * for `--work_usec`, so every scheduler queue is always full.  A `Driver`
+ * cown sends `--requests` behaviours, one each time it runs, to a dispatcher
+ * cown, and each records the time between being sent and starting to run.
+ *
+ * The benchmark is run with the dispatcher at `Priority::Normal`, where each
+ * request waits behind the workers in its scheduler queue, and then at
+ * `Priority::High`, see `Cown::set_priority`.  For each it reports the
+ * median, 99th percentile and maximum latency of the requests, and the
+ * background behaviours completed.
+ */
+
+#include "test/log.h"
+#include "test/opt.h"
+#include "verona.h"
+
+#include <algorithm>
+#include <test/harness.h>
+
+namespace sn = snmalloc;
+namespace rt = verona::rt;
+
+static size_t work_usec = 0;
+static std::atomic<bool> stopped = false;
+static std::atomic<size_t> background_done = 0;
+
+struct Worker : public VCown<Worker>
+{};
+
+struct Work : public VBehaviour<Work>
+{
+  Worker* worker;
+
+  Work(Worker* worker) : worker(worker) {}
+
+  void f()
+  {
+    busy_loop(work_usec);
+    background_done++;
+
+    if (!stopped)
+      rt::Cown::schedule<Work>(worker, worker);
+  }
+};
+
+struct Dispatcher : public VCown<Dispatcher>
+{
+  std::vector<uint64_t> latencies;
+};
+
+struct Dispatch : public VBehaviour<Dispatch>
+{
+  Dispatcher* dispatcher;
+  uint64_t sent;
+
+  Dispatch(Dispatcher* dispatcher)
+  : dispatcher(dispatcher), sent(sn::Aal::tick())
+  {}
+
+  void f()
+  {
+    dispatcher->latencies.push_back(sn::Aal::tick() - sent);
+  }
+};
+
+/**
+ * Runs after all of the requests, and stops the workers.
+ */
+struct Report : public VBehaviour<Report>
+{
+  Dispatcher* dispatcher;
+
+  Report(Dispatcher* dispatcher) : dispatcher(dispatcher) {}
+
+  void f()
+  {
+    stopped = true;
+
+    auto& latencies = dispatcher->latencies;
+    std::sort(latencies.begin(), latencies.end());
+    check(!latencies.empty());
+
+    logger::cout() << "request latency (cycles): p50 "
+                   << latencies[latencies.size() / 2] << ", p99 "
+                   << latencies[(latencies.size() * 99) / 100] << ", max "
+                   << latencies.back() << ", background behaviours "
+                   << background_done << std::endl;
+  }
+};
+
+struct Driver : public VCown<Driver>
+{
+  Dispatcher* dispatcher;
+  size_t requests;
+
+  Driver(Dispatcher* dispatcher, size_t requests)
+  : dispatcher(dispatcher), requests(requests)
+  {}
+
+  void trace(rt::ObjectStack& st) const
+  {
+    st.push(dispatcher);
+  }
+};
+
+struct Round : public VBehaviour<Round>
+{
+  Driver* driver;
+
+  Round(Driver* driver) : driver(driver) {}
+
+  void f()
+  {
+    auto* dispatcher = driver->dispatcher;
+    rt::Cown::schedule<Dispatch>(dispatcher, dispatcher);
+
+    if (--driver->requests != 0)
+    {
+      rt::Cown::schedule<Round>(driver, driver);
+      return;
+    }
+
+    rt::Cown::schedule<Report>(dispatcher, dispatcher);
+  }
+};
+
+void run(size_t cores, size_t background, size_t requests, rt::Priority p)
+{
+  auto& alloc = sn::ThreadAlloc::get();
+  auto& sched = rt::Scheduler::get();
+  sched.init(cores);
+  stopped = false;
+  background_done = 0;
+
+  for (size_t i = 0; i < background; i++)
+  {
+    auto* w = new (alloc) Worker;
+    rt::Cown::schedule<Work, rt::YesTransfer>(w, w);
+  }
+
+  auto* dispatcher = new (alloc) Dispatcher;
+  dispatcher->set_priority(p);
+  auto* driver = new (alloc) Driver(dispatcher, requests);
+  rt::Cown::schedule<Round, rt::YesTransfer>(driver, driver);
+
+  logger::cout() << "dispatcher priority: "
+                 << (p == rt::Priority::High ? "high" : "normal") << std::endl;
+  sched.run();
+}
+
+int main(int argc, char** argv)
+{
+  opt::Opt opt(argc, argv);
+  const auto cores = opt.is<size_t>("--cores", 4);
+  const auto background = opt.is<size_t>("--background", 64);
+  const auto requests = opt.is<size_t>("--requests", 200);
+  work_usec = opt.is<size_t>("--work_usec", 20);
+
+  logger::cout() << "cores: " << cores << ", background: " << background
+                 << ", requests: " << requests << ", work_usec: " << work_usec
+                 << std::endl;
+
+  run(cores, background, requests, rt::Priority::Normal);
+  run(cores, background, requests, rt::Priority::High);
+  return 0;
+}
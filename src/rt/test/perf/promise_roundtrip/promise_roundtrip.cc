@@ -0,0 +1,118 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * This benchmark compares the round trip through a `Promise` with that
+ * through an `InlinePromise`.
+ *
+ * Each of `--clients` clients makes `--requests` requests, one at a time, to
+ * one of `--servers` servers.  A request is a behaviour on the server, which
+ * fulfils a promise with the server's count, and the client makes its next
+ * request from the continuation of that promise.  The continuation of a
+ * `Promise` is a behaviour on the promise, and that of an `InlinePromise` is
+ * run by the server's behaviour.  The benchmark runs both, and reports the
+ * time each took.
+ */
+
+#include "test/log.h"
+#include "test/opt.h"
+
+#include <chrono>
+#include <cpp/when.h>
+#include <test/harness.h>
+
+using namespace verona::cpp;
+using timer = std::chrono::high_resolution_clock;
+
+struct Server
+{
+  uint64_t count = 0;
+};
+
+static std::vector<cown_ptr<Server>> servers;
+static size_t requests = 0;
+static size_t clients = 0;
+static std::atomic<size_t> finished = 0;
+static std::atomic<uint64_t> total = 0;
+
+/**
+ * Called at the end of each client.  The last one releases the servers.
+ */
+void finish(uint64_t sum)
+{
+  total += sum;
+  if (++finished == clients)
+    servers.clear();
+}
+
+template<template<typename> typename P>
+void request(size_t client, size_t sent, uint64_t sum)
+{
+  if (sent == requests)
+  {
+    finish(sum);
+    return;
+  }
+
+  auto pp = P<uint64_t>::create_promise();
+  auto& server = servers[(client + sent) % servers.size()];
+  when(server) << [wp = std::move(pp.second)](
+                    acquired_cown<Server> s) mutable {
+    uint64_t count = ++s->count;
+    P<uint64_t>::fulfill(std::move(wp), std::move(count));
+  };
+
+  pp.first.then(
+    [client, sent, sum](std::variant<uint64_t, typename P<uint64_t>::PromiseErr>
+                          v) {
+      check(std::holds_alternative<uint64_t>(v));
+      request<P>(client, sent + 1, sum + std::get<uint64_t>(v));
+    });
+}
+
+template<template<typename> typename P>
+void run(const char* name, size_t cores, size_t count)
+{
+  auto& sched = Scheduler::get();
+  sched.init(cores);
+
+  for (size_t i = 0; i < count; i++)
+    servers.push_back(make_cown<Server>());
+
+  finished = 0;
+  total = 0;
+  auto start = timer::now();
+  for (size_t i = 0; i < clients; i++)
+    schedule_lambda([i]() { request<P>(i, 0, 0); });
+  sched.run();
+  auto t = std::chrono::duration_cast<std::chrono::milliseconds>(
+    timer::now() - start);
+
+  // Each server counts from one to the number of requests it served.
+  size_t n = clients * requests;
+  uint64_t expected = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    uint64_t served = (n / count) + (i < (n % count) ? 1 : 0);
+    expected += served * (served + 1) / 2;
+  }
+  check(total == expected);
+  logger::cout() << name << ": " << t.count() << "ms" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  opt::Opt opt(argc, argv);
+  const auto cores = opt.is<size_t>("--cores", 4);
+  clients = opt.is<size_t>("--clients", 1000);
+  const auto count = opt.is<size_t>("--servers", 100);
+  requests = opt.is<size_t>("--requests", 1000);
+
+  logger::cout() << "cores: " << cores << ", clients: " << clients
+                 << ", servers: " << count << ", requests: " << requests
+                 << std::endl;
+
+  run<Promise>("promise", cores, count);
+  run<InlinePromise>("inline promise", cores, count);
+  return 0;
+}
@@ -0,0 +1,142 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * This benchmark is for measuring how read-only behaviours on one shared
+ * cown scale with the number of cores, see `Cown::mark_read_mostly`.
+ *
+ * One `Sender` cown per core runs `--rounds` rounds.  In each round it sends
+ * the shared `Table` cown `--reads` read-only behaviours, and every
+ * `--write-every` rounds one behaviour that writes to it.  Every read-only
+ * behaviour adds and removes a reader, so with a single count the cores
+ * contend for its cache line.  With `--read-mostly` the table counts its
+ * readers on a line per core instead.
+ *
+ * The benchmark reports the throughput, to compare the two counts.
+ */
+
+#include "test/log.h"
+#include "test/opt.h"
+#include "verona.h"
+
+#include <test/harness.h>
+
+namespace sn = snmalloc;
+namespace rt = verona::rt;
+
+struct Table : public VCown<Table>
+{
+  uint64_t writes = 0;
+};
+
+static Table* table = nullptr;
+static std::atomic<size_t> senders_left = 0;
+static size_t rounds = 0;
+static size_t reads = 0;
+static size_t write_every = 0;
+static uint64_t writes = 0;
+static size_t behaviours = 0;
+static uint64_t start = 0;
+
+struct Read : public VBehaviour<Read>
+{
+  void f()
+  {
+    check(table->writes <= writes);
+  }
+};
+
+struct Write : public VBehaviour<Write>
+{
+  void f()
+  {
+    table->writes++;
+  }
+};
+
+/**
+ * Runs once every sender has finished, and so after every other behaviour on
+ * the table.
+ */
+struct Report : public VBehaviour<Report>
+{
+  void f()
+  {
+    auto end = sn::Aal::tick();
+
+    check(table->writes == writes);
+
+    logger::cout() << "throughput: "
+                   << (behaviours * 1'000'000) / ((end - start) + 1)
+                   << " behaviours per million cycles" << std::endl;
+
+    rt::Cown::release(sn::ThreadAlloc::get(), table);
+  }
+};
+
+struct Sender : public VCown<Sender>
+{
+  size_t left = rounds;
+};
+
+struct Round : public VBehaviour<Round>
+{
+  Sender* sender;
+
+  Round(Sender* sender) : sender(sender) {}
+
+  void f()
+  {
+    auto request = rt::Request::read(table);
+    for (size_t i = 0; i < reads; i++)
+      rt::Cown::schedule<Read>(1, &request);
+
+    if ((sender->left % write_every) == 0)
+      rt::Cown::schedule<Write>(table);
+
+    if (--sender->left != 0)
+    {
+      rt::Cown::schedule<Round>(sender, sender);
+      return;
+    }
+
+    rt::Cown::release(sn::ThreadAlloc::get(), sender);
+    if (--senders_left == 0)
+      rt::Cown::schedule<Report>(table);
+  }
+};
+
+int main(int argc, char** argv)
+{
+  opt::Opt opt(argc, argv);
+  const auto cores = opt.is<size_t>("--cores", 4);
+  const auto read_mostly = opt.has("--read-mostly");
+  rounds = opt.is<size_t>("--rounds", 1000);
+  reads = opt.is<size_t>("--reads", 16);
+  write_every = std::max<size_t>(opt.is<size_t>("--write-every", 10), 1);
+
+  logger::cout() << "cores: " << cores << ", rounds: " << rounds
+                 << ", reads: " << reads << ", write every: " << write_every
+                 << ", read-mostly: " << read_mostly << std::endl;
+
+  auto& alloc = sn::ThreadAlloc::get();
+  auto& sched = rt::Scheduler::get();
+  sched.init(cores);
+
+  table = new (alloc) Table;
+  if (read_mostly)
+    table->mark_read_mostly();
+
+  writes = cores * (rounds / write_every);
+  behaviours = cores * (rounds * reads + rounds / write_every);
+  senders_left = cores;
+  for (size_t i = 0; i < cores; i++)
+  {
+    auto* sender = new (alloc) Sender;
+    rt::Cown::schedule<Round>(sender, sender);
+  }
+
+  start = sn::Aal::tick();
+  sched.run();
+  return 0;
+}
@@ -6,6 +6,9 @@
  *
  * There are n cowns, each executing m writes to a large statically allocated
  * array of memory.  Each cown performs c behaviours.
+ *
+ * `--steal_batch` sets the most cowns an idle scheduler thread takes from
+ * another core in one steal, see `ThreadPool::set_steal_batch`.
  */
 
 #include "test/log.h"
@@ -80,9 +83,11 @@ int main(int argc, char** argv)
   global_array = new std::atomic<size_t>[global_array_size];
   const auto loops = opt.is<size_t>("--loops", 100);
   writes = opt.is<size_t>("--writes", 0);
+  const auto steal_batch = opt.is<size_t>("--steal_batch", 1);
 
   auto& sched = rt::Scheduler::get();
   sched.set_fair(true);
+  sched.set_steal_batch(steal_batch);
   for (int l = 0; l < 20; l++)
   {
     sched.init(cores);
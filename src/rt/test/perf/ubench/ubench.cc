@@ -14,6 +14,16 @@
  * may randomly choose to include itself in the forwarded `Ping` multi-message
  * along with the selected recipient. By default 5% of `Ping` messages will
  * become these multi-messages.
+ *
+ * `--inline_depth` and `--inline_count` set the scheduler's budget for
+ * running a multi-message's behaviour inline on the thread that acquired its
+ * last cown, see `ThreadPool::set_inline_budget`.
+ *
+ * Each report includes the steals and mean batch size so far, from
+ * `Scheduler::snapshot_stats`, the number of blocks per behaviour that the
+ * `MessagePool`s took from the allocator, and the share of their blocks that
+ * were reused instead.  The `perf-con-ubench_stats` variant is built with
+ * `USE_SCHED_STATS`, and also prints all of the scheduler statistics on exit.
  */
 
 #include "test/log.h"
@@ -220,7 +230,16 @@ namespace ubench
         sum += p->count;
 
       uint64_t rate = (sum * 1'000'000'000) / t;
-      logger::cout() << t << " ns, " << rate << " msgs/s" << std::endl;
+      auto stats = rt::Scheduler::snapshot_stats();
+      uint64_t pooled = (stats.pooled_allocs * 100) /
+        std::max<uint64_t>(stats.allocs + stats.pooled_allocs, 1);
+      double allocs_per_behaviour = (double)stats.allocs /
+        (double)std::max<uint64_t>(stats.behaviours_scheduled, 1);
+      logger::cout() << t << " ns, " << rate << " msgs/s, "
+                     << stats.steals << " steals, mean batch "
+                     << stats.mean_batch_size() << ", "
+                     << allocs_per_behaviour << " allocs/behaviour, "
+                     << pooled << "% of blocks pooled" << std::endl;
     }
   };
 }
@@ -239,13 +258,15 @@ int main(int argc, char** argv)
   const auto initial_pings = opt.is<size_t>("--initial_pings", 5);
   const auto percent_multimessage = opt.is<size_t>("--percent_multimessage", 5);
   check(percent_multimessage <= 100);
+  const auto inline_depth = opt.is<size_t>("--inline_depth", 0);
+  const auto inline_count = opt.is<size_t>("--inline_count", 16);
 
   logger::cout() << "cores: " << cores
                  << ", report_interval: " << report_interval.count()
                  << ", pingers: " << pingers
                  << ", initial_pings: " << initial_pings
                  << ", percent_mutlimessage: " << percent_multimessage
-                 << std::endl;
+                 << ", inline_depth: " << inline_depth << std::endl;
 
   auto& alloc = sn::ThreadAlloc::get();
 #ifdef USE_SYSTEMATIC_TESTING
@@ -256,6 +277,7 @@ int main(int argc, char** argv)
 #endif
   auto& sched = rt::Scheduler::get();
   sched.set_fair(true);
+  sched.set_inline_budget(inline_depth, inline_count);
   sched.init(cores);
 
   static vector<Pinger*> pinger_set;
@@ -0,0 +1,156 @@
+// Copyright Microsoft and Project Verona Contributors.
+// SPDX-License-Identifier: MIT
+
+/**
+ * This benchmark is for measuring how quickly idle scheduler threads wake up
+ * to new work, and the CPU time they use while idle.
+ *
+ * A thread outside the runtime sends `--requests` behaviours to a `Sink`
+ * cown, one every `--interval_usec`, so the scheduler threads run out of
+ * work and pause between them.  Each behaviour records the time between being
+ * sent and starting to run.
+ *
+ * The benchmark is run for each of a range of spin budgets, or just for
+ * `--spin_cycles`, see `ThreadPool::set_spin_budget`.  For each it reports
+ * the median, 99th percentile and maximum latency of the requests, and the
+ * CPU time used by the process as a percentage of one core.
+ */
+
+#include "test/log.h"
+#include "test/opt.h"
+#include "verona.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sys/resource.h>
+#include <test/harness.h>
+#include <thread>
+
+namespace sn = snmalloc;
+namespace rt = verona::rt;
+
+struct Sink : public VCown<Sink>
+{
+  std::vector<uint64_t> latencies;
+};
+
+struct Ping : public VBehaviour<Ping>
+{
+  Sink* sink;
+  uint64_t sent;
+
+  Ping(Sink* sink) : sink(sink), sent(sn::Aal::tick()) {}
+
+  void f()
+  {
+    sink->latencies.push_back(sn::Aal::tick() - sent);
+  }
+};
+
+struct Report : public VBehaviour<Report>
+{
+  Sink* sink;
+
+  Report(Sink* sink) : sink(sink) {}
+
+  void f()
+  {
+    auto& latencies = sink->latencies;
+    std::sort(latencies.begin(), latencies.end());
+    check(!latencies.empty());
+
+    logger::cout() << "wakeup latency (cycles): p50 "
+                   << latencies[latencies.size() / 2] << ", p99 "
+                   << latencies[(latencies.size() * 99) / 100] << ", max "
+                   << latencies.back() << std::endl;
+
+    rt::Scheduler::remove_external_event_source();
+  }
+};
+
+struct Start : public VBehaviour<Start>
+{
+  Sink* sink;
+  size_t requests;
+  std::chrono::microseconds interval;
+
+  Start(Sink* sink, size_t requests, std::chrono::microseconds interval)
+  : sink(sink), requests(requests), interval(interval)
+  {}
+
+  void f()
+  {
+    rt::Scheduler::add_external_event_source();
+
+    // The sender's reference is released by `Report`.
+    rt::Cown::acquire(sink);
+    std::thread([sink = sink, requests = requests, interval = interval]() {
+      for (size_t i = 0; i < requests; i++)
+      {
+        std::this_thread::sleep_for(interval);
+        rt::Cown::schedule<Ping>(sink, sink);
+      }
+      rt::Cown::schedule<Report, rt::YesTransfer>(sink, sink);
+    }).detach();
+  }
+};
+
+static uint64_t cpu_usec()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  auto usec = [](const timeval& t) {
+    return ((uint64_t)t.tv_sec * 1'000'000) + (uint64_t)t.tv_usec;
+  };
+  return usec(usage.ru_utime) + usec(usage.ru_stime);
+}
+
+void run(
+  size_t cores,
+  size_t requests,
+  std::chrono::microseconds interval,
+  uint64_t spin_cycles)
+{
+  auto& alloc = sn::ThreadAlloc::get();
+  auto& sched = rt::Scheduler::get();
+  sched.set_spin_budget(spin_cycles);
+  sched.init(cores);
+
+  auto* sink = new (alloc) Sink;
+  rt::Cown::schedule<Start, rt::YesTransfer>(sink, sink, requests, interval);
+
+  logger::cout() << "spin budget: " << spin_cycles << " cycles" << std::endl;
+
+  auto cpu_start = cpu_usec();
+  auto start = std::chrono::steady_clock::now();
+  sched.run();
+  auto wall = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  auto cpu = cpu_usec() - cpu_start;
+
+  logger::cout() << "cpu: " << ((cpu * 100) / (uint64_t)wall)
+                 << "% of one core" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  opt::Opt opt(argc, argv);
+  const auto cores = opt.is<size_t>("--cores", 4);
+  const auto requests = opt.is<size_t>("--requests", 200);
+  const auto interval =
+    std::chrono::microseconds(opt.is<size_t>("--interval_usec", 1000));
+
+  logger::cout() << "cores: " << cores << ", requests: " << requests
+                 << ", interval_usec: " << interval.count() << std::endl;
+
+  if (opt.has("--spin_cycles"))
+  {
+    run(cores, requests, interval, opt.is<uint64_t>("--spin_cycles", 0));
+    return 0;
+  }
+
+  for (uint64_t spin_cycles : {10'000, 1'000'000, 100'000'000})
+    run(cores, requests, interval, spin_cycles);
+  return 0;
+}
@@ -7,6 +7,7 @@
 #  define SNMALLOC_USE_THREAD_DESTRUCTOR 1
 #endif
 
+#include "cpp/inlinepromise.h"
 #include "cpp/lambdabehaviour.h"
 #include "cpp/promise.h"
 #include "cpp/vbehaviour.h"